@@ -27,13 +27,36 @@
 #include <sstream>
 #include <stdexcept>
 #include <unordered_map>
+#include <unordered_set>
 #include <functional>
+#include <memory>
+#include <array>
+#include <string_view>
+#include <chrono>
+#include <charconv>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <bit>
+#include <cstring>
+#include <variant>
+#include <new>
+#include <type_traits>
+#include <coroutine>
+#include <exception>
+#include <span>
+#include <utility>
+#include <iterator>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 /* ============================================================================================================================== */
 
-int SPACES = 12;
+constexpr int SPACES = 12;
 
-std::string LICENSENOTICE = R"(
+constexpr std::string_view LICENSENOTICE = R"(
 This program uses the libcmd library with following copyright notice and license text:
 
 Copyright (c) 2021, 2023 Adam McKellar
@@ -54,7 +77,152 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
 /* ============================================================================================================================== */
 
-enum Type {BOOL, STRING, INT, DOUBLE, LAMBDA};
+enum Type {BOOL, STRING, INT, DOUBLE, LAMBDA, CHOICE, DURATION, BYTES};
+
+constexpr std::size_t MAX_SPEC_HANDS = 6;
+
+/**
+ * Compile time description of an Option, used to render help text at compile time and for the built in flags.
+ * 
+ * The hands are given in a fixed size array, unused entries stay empty.
+ * For CHOICE options choices holds the accepted strings separated by "|", like "fast|safe|replay".
+ */
+struct OptionSpec {
+    Type type;
+    std::array<std::string_view, MAX_SPEC_HANDS> hands;
+    std::string_view description = "";
+    std::array<std::string_view, MAX_SPEC_HANDS> anonymousHands = {};
+    std::string_view choices = "";
+
+    constexpr int handCount() const {
+        int count = 0;
+        for (auto& hand : hands) if (!hand.empty()) ++count;
+        return count;
+    }
+};
+
+/// @brief The -h/--help flag every CmdParser and SubCommand adds on its own.
+constexpr OptionSpec HELP_OPTION {LAMBDA, {"-h", "--help"}, "Show this message.", {"/h"}};
+
+/// @brief The --license flag every CmdParser adds on its own.
+constexpr OptionSpec LICENSE_OPTION {LAMBDA, {"--license"}, "Print licenses.", {"--License", "/License", "/license"}};
+
+/// @brief The flags CmdParser handles itself, without an Option. SubCommands only have the first one.
+constexpr std::array<OptionSpec, 2> BUILT_IN_OPTIONS {HELP_OPTION, LICENSE_OPTION};
+
+
+/**
+ * Compile time table of the strings accepted by a choice Option and the values they map to.
+ * 
+ * Declare it static constexpr and pass it with choicesOf, as the Option only keeps a pointer to it:
+ * static constexpr Choices<Mode, 3> modes {{"fast", "safe", "replay"}, {Mode::FAST, Mode::SAFE, Mode::REPLAY}};
+ * Option(&mode, choicesOf<modes>, {"-m", "--mode"}, "execution mode")
+ */
+template<typename E, std::size_t N>
+struct Choices {
+    std::array<std::string_view, N> names;
+    std::array<E, N> values;
+};
+
+/// @brief Names a Choices table with static storage duration, see choicesOf.
+template<const auto& Table>
+struct ChoiceTable {};
+
+/// @brief The Choices table of a choice Option. Being a template argument, tables which are temporaries or non static locals do not compile.
+template<const auto& Table>
+constexpr ChoiceTable<Table> choicesOf {};
+
+/// @brief Index into the Choices of a choice Option.
+struct ChoiceIndex {
+    std::size_t index;
+};
+
+/// @brief A value converted from a command line argument. Flags carry std::monostate.
+using OptionValue = std::variant<std::monostate, std::string_view, int, double, std::chrono::nanoseconds, std::uint64_t, ChoiceIndex>;
+
+constexpr std::size_t CALLBACK_CAPACITY = 4 * sizeof(void*);
+
+template<typename Signature, std::size_t Capacity = CALLBACK_CAPACITY>
+class InplaceFunction;
+
+/**
+ * Copyable callable, which stores the callable inside itself and never allocates.
+ * 
+ * Callables larger than Capacity are rejected at compile time. Capture a pointer or reference to larger state instead.
+ */
+template<typename R, typename... Args, std::size_t Capacity>
+class InplaceFunction<R(Args...), Capacity> {
+private:
+    alignas(std::max_align_t) unsigned char _storage[Capacity];
+    R (*_invoke)(void* callable, Args... args) = nullptr;
+    void (*_copy)(void* to, const void* from) = nullptr;
+    void (*_destroy)(void* callable) = nullptr;
+
+public:
+    InplaceFunction() = default;
+
+    template<typename F>
+        requires (!std::is_same_v<std::decay_t<F>, InplaceFunction> && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>)
+    InplaceFunction(F&& callable) {
+        using Callable = std::decay_t<F>;
+        static_assert(sizeof(Callable) <= Capacity, "libcmd: callback captures too much to be stored without allocation, capture a pointer instead");
+        static_assert(alignof(Callable) <= alignof(std::max_align_t), "libcmd: callback is over aligned");
+        new (_storage) Callable(std::forward<F>(callable));
+        _invoke = [](void* callable, Args... args) -> R { return (*static_cast<Callable*>(callable))(std::forward<Args>(args)...); };
+        _copy = [](void* to, const void* from) { new (to) Callable(*static_cast<const Callable*>(from)); };
+        _destroy = [](void* callable) { static_cast<Callable*>(callable)->~Callable(); };
+    }
+
+    InplaceFunction(const InplaceFunction& other) : _invoke(other._invoke), _copy(other._copy), _destroy(other._destroy) {
+        if (_copy) _copy(_storage, other._storage);
+    }
+
+    InplaceFunction& operator=(const InplaceFunction& other) {
+        if (this != &other) {
+            if (_destroy) _destroy(_storage);
+            _invoke = other._invoke;
+            _copy = other._copy;
+            _destroy = other._destroy;
+            if (_copy) _copy(_storage, other._storage);
+        }
+        return *this;
+    }
+
+    ~InplaceFunction() {
+        if (_destroy) _destroy(_storage);
+    }
+
+    explicit operator bool() const {
+        return _invoke != nullptr;
+    }
+
+    R operator()(Args... args) {
+        return _invoke(_storage, std::forward<Args>(args)...);
+    }
+};
+
+/// @brief The parameter type of a call operator, void if it takes none. No type for other signatures.
+template<typename Signature>
+struct CallbackSignature {};
+
+template<typename C, typename R>
+struct CallbackSignature<R (C::*)() const> { using type = void; };
+
+template<typename C, typename R>
+struct CallbackSignature<R (C::*)()> { using type = void; };
+
+template<typename C, typename R, typename A>
+struct CallbackSignature<R (C::*)(A) const> { using type = std::remove_cvref_t<A>; };
+
+template<typename C, typename R, typename A>
+struct CallbackSignature<R (C::*)(A)> { using type = std::remove_cvref_t<A>; };
+
+/// @brief The parameter type of a callback, void if it takes none. No type for generic lambdas or overloaded call operators.
+template<typename F, typename = void>
+struct CallbackArgument {};
+
+template<typename F>
+struct CallbackArgument<F, std::void_t<decltype(&F::operator())>> : CallbackSignature<decltype(&F::operator())> {};
 
 /**
  * Class for handling Options.
@@ -64,6 +232,10 @@ enum Type {BOOL, STRING, INT, DOUBLE, LAMBDA};
  * 2. All strings to be identified as option/flag.
  * 3. The description for the help message.
  * 4. All strings to be identified as option/flag you do not wish to print.
+ * 
+ * Instead of a variable, a callback can receive the parsed value. The type of its parameter decides the type of the Option:
+ * none for a flag, int, double, std::string_view, std::chrono::nanoseconds or std::uint64_t (byte size).
+ * Callbacks are stored without allocation and may capture up to CALLBACK_CAPACITY bytes.
  */
 class Option {
 private:
@@ -78,6 +250,9 @@ public:
         std::string* pointerString;
         int* pointerInt;
         double* pointerDouble;
+        void* pointerChoice;
+        std::chrono::nanoseconds* pointerDuration;
+        std::uint64_t* pointerBytes;
     };  
     std::function<void(void*)> flagLambda;
 
@@ -86,11 +261,62 @@ public:
     Option (int* pointer, std::vector<std::string> hands, std::string description = "", std::vector<std::string> anonymousHands = {});
     Option (double* pointer, std::vector<std::string> hands, std::string description = "", std::vector<std::string> anonymousHands = {});
     Option (std::function<void(void*)> lambda, std::vector<std::string> hands, std::string description = "", std::vector<std::string> anonymousHands = {});
+    Option (std::chrono::nanoseconds* pointer, std::vector<std::string> hands, std::string description = "", std::vector<std::string> anonymousHands = {});
+    Option (std::uint64_t* pointer, std::vector<std::string> hands, std::string description = "", std::vector<std::string> anonymousHands = {});
+
+    template<typename F>
+        requires (std::is_class_v<F> && !std::is_same_v<F, std::function<void(void*)>>
+            && requires { typename CallbackArgument<F>::type; } && !std::is_same_v<typename CallbackArgument<F>::type, void*>)
+    Option (F callback, std::vector<std::string> hands, std::string description = "", std::vector<std::string> anonymousHands = {})
+        : _hands(hands), _anonymousHands(anonymousHands), _description(description), pointerBool(nullptr)
+    {
+        using Argument = typename CallbackArgument<F>::type;
+        if constexpr (std::is_void_v<Argument>) {
+            _type = Type::BOOL;
+            _callback = [callback](const OptionValue&) mutable { callback(); };
+        } else {
+            if constexpr (std::is_same_v<Argument, int>) _type = Type::INT;
+            else if constexpr (std::is_same_v<Argument, double>) _type = Type::DOUBLE;
+            else if constexpr (std::is_same_v<Argument, std::string_view>) _type = Type::STRING;
+            else if constexpr (std::is_same_v<Argument, std::chrono::nanoseconds>) _type = Type::DURATION;
+            else if constexpr (std::is_same_v<Argument, std::uint64_t>) _type = Type::BYTES;
+            else static_assert(!sizeof(F), "libcmd: callback must take no parameter or one of int, double, std::string_view, std::chrono::nanoseconds, std::uint64_t");
+            _callback = [callback](const OptionValue& value) mutable { callback(std::get<Argument>(value)); };
+        }
+    }
+
+    template<typename E, const auto& Table>
+    Option (E* pointer, ChoiceTable<Table>, std::vector<std::string> hands, std::string description = "", std::vector<std::string> anonymousHands = {})
+        : _type(Type::CHOICE), _hands(hands), _anonymousHands(anonymousHands), _description(description), pointerChoice(pointer),
+          _choiceNames(Table.names.data()), _choiceValues(Table.values.data()), _choiceCount(Table.names.size()),
+          _assignChoice([](void* target, const void* values, std::size_t index) {
+              *static_cast<E*>(target) = static_cast<const E*>(values)[index];
+          })
+    {
+        static_assert(std::is_same_v<typename decltype(Table.values)::value_type, E>, "libcmd: the Choices table does not map to the type of the variable");
+    }
 
-    Type getType();
-    std::vector<std::string> getHands();
-    std::string getDescription();
-    std::vector<std::string> getAnonymousHands();
+    Type getType() const;
+    const std::vector<std::string>& getHands() const;
+    std::string getDescription() const;
+    const std::vector<std::string>& getAnonymousHands() const;
+    std::size_t getChoiceCount() const;
+    std::string_view getChoice(std::size_t index) const;
+    std::size_t findChoice(std::string_view name) const;
+    void assignChoice(std::size_t index);
+    std::string getChoiceList() const;
+    Option& setReloadable(bool reloadable = true);
+    bool isReloadable() const;
+    std::string convertValue(std::string_view text, OptionValue& value) const;
+    void applyValue(const OptionValue& value, void* self);
+
+private:
+    InplaceFunction<void(const OptionValue&)> _callback;
+    bool _reloadable = false;
+    const std::string_view* _choiceNames = nullptr;
+    const void* _choiceValues = nullptr;
+    std::size_t _choiceCount = 0;
+    void (*_assignChoice)(void* target, const void* values, std::size_t index) = nullptr;
 };
 
 
@@ -109,25 +335,625 @@ Option::Option (double* pointer, std::vector<std::string> hands, std::string des
 Option::Option (std::function<void(void*)> lambda, std::vector<std::string> hands, std::string description, std::vector<std::string> anonymousHands)
         : _hands(hands), _description(description), _type(Type::LAMBDA), flagLambda(lambda), _anonymousHands(anonymousHands) {}
 
-Type Option::getType() {
+Option::Option (std::chrono::nanoseconds* pointer, std::vector<std::string> hands, std::string description, std::vector<std::string> anonymousHands)
+        : _type(Type::DURATION), _hands(hands), _anonymousHands(anonymousHands), _description(description), pointerDuration(pointer) {}
+
+Option::Option (std::uint64_t* pointer, std::vector<std::string> hands, std::string description, std::vector<std::string> anonymousHands)
+        : _type(Type::BYTES), _hands(hands), _anonymousHands(anonymousHands), _description(description), pointerBytes(pointer) {}
+
+Type Option::getType() const {
     return _type;
 }
 
-std::vector<std::string> Option::getHands() {
+const std::vector<std::string>& Option::getHands() const {
     return _hands;
 }
 
-std::string Option::getDescription() {
+std::string Option::getDescription() const {
     return _description;
 }
 
-std::vector<std::string> Option::getAnonymousHands() {
+const std::vector<std::string>& Option::getAnonymousHands() const {
     return _anonymousHands;
 }
 
+std::size_t Option::getChoiceCount() const {
+    return _choiceCount;
+}
+
+/**
+ * @brief Return the string of the choice at index, like findChoice() would match it.
+ */
+std::string_view Option::getChoice(std::size_t index) const {
+    return _choiceNames[index];
+}
+
+/**
+ * @brief Look up a string in the choice table of a choice Option.
+ * 
+ * @param name The string to look up.
+ * @return std::size_t Index of the matching choice or the number of choices if there is none.
+ */
+std::size_t Option::findChoice(std::string_view name) const {
+    for (std::size_t i = 0; i < _choiceCount; ++i) {
+        if (_choiceNames[i] == name) return i;
+    }
+    return _choiceCount;
+}
+
+/**
+ * @brief Write the value of the choice at index to the variable of the choice Option.
+ * 
+ * @param index Index into the choice table as returned by findChoice().
+ */
+void Option::assignChoice(std::size_t index) {
+    _assignChoice(pointerChoice, _choiceValues, index);
+}
+
+/**
+ * @brief Return all choices of a choice Option separated by "|".
+ * 
+ * @return std::string Example: "fast|safe|replay".
+ */
+std::string Option::getChoiceList() const {
+    std::string list;
+    for (std::size_t i = 0; i < _choiceCount; ++i) {
+        if (i != 0) list += "|";
+        list += _choiceNames[i];
+    }
+    return list;
+}
+
+
+/**
+ * @brief Mark the Option as safe to change while the program runs. Only reloadable Options are updated by a ConfigReloader.
+ * 
+ * @param reloadable Whether the Option may be reloaded.
+ * @return Option& This Option, so it can be used directly in the Option list.
+ */
+Option& Option::setReloadable(bool reloadable) {
+    _reloadable = reloadable;
+    return *this;
+}
+
+bool Option::isReloadable() const {
+    return _reloadable;
+}
+
+
+/* ============================================================================================================================== */
+
+/**
+ * @brief Read a decimal number with an optional fraction like "1.5" from the front of text.
+ * 
+ * Fraction digits beyond the ninth are dropped.
+ * 
+ * @param text Text to read from. The number is removed from its front.
+ * @param whole The integer part.
+ * @param fraction The fraction digits as integer.
+ * @param fractionScale 10 to the power of the number of fraction digits kept.
+ * @return false if text does not start with a number or the integer part overflows.
+ */
+bool readDecimal(std::string_view& text, std::uint64_t& whole, std::uint64_t& fraction, std::uint64_t& fractionScale) {
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), whole);
+    if (ec != std::errc()) return false;
+    text.remove_prefix(end - text.data());
+
+    fraction = 0;
+    fractionScale = 1;
+    if (!text.empty() && text.front() == '.') {
+        text.remove_prefix(1);
+        int digits = 0;
+        while (!text.empty() && text.front() >= '0' && text.front() <= '9') {
+            if (fractionScale < 1000000000) {
+                fraction = fraction * 10 + (text.front() - '0');
+                fractionScale *= 10;
+            }
+            text.remove_prefix(1);
+            ++digits;
+        }
+        if (digits == 0) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Multiply a number read by readDecimal() with a unit and round down.
+ * 
+ * @return false if the result does not fit into limit.
+ */
+bool scaleDecimal(std::uint64_t whole, std::uint64_t fraction, std::uint64_t fractionScale, std::uint64_t unit, std::uint64_t limit, std::uint64_t& result) {
+    if (whole > limit / unit) return false;
+    result = whole * unit;
+    // fraction < fractionScale <= 10^9, so neither product can overflow.
+    std::uint64_t part = fraction * (unit / fractionScale) + fraction * (unit % fractionScale) / fractionScale;
+    if (result > limit - part) return false;
+    result += part;
+    return true;
+}
+
+/**
+ * @brief Parse a duration like "250ms", "1h30m" or "1.5s".
+ * 
+ * Known units are ns, us, ms, s, m, h and d. Every number needs a unit, with the exception of a plain "0".
+ * 
+ * @param text The text to parse.
+ * @param duration Set to the parsed duration on success.
+ * @return false if text is no valid duration or does not fit into std::chrono::nanoseconds.
+ */
+bool parseDuration(std::string_view text, std::chrono::nanoseconds& duration) {
+    static constexpr std::array<std::pair<std::string_view, std::uint64_t>, 8> units {{
+        {"ns", 1}, {"us", 1000}, {"ms", 1000000}, {"s", 1000000000},
+        {"m", 60000000000}, {"h", 3600000000000}, {"d", 86400000000000}, {"\u00b5s", 1000}
+    }};
+    constexpr std::uint64_t limit = std::numeric_limits<std::chrono::nanoseconds::rep>::max();
+
+    if (text == "0") {
+        duration = std::chrono::nanoseconds(0);
+        return true;
+    }
+    if (text.empty()) return false;
+
+    std::uint64_t total = 0;
+    while (!text.empty()) {
+        std::uint64_t whole, fraction, fractionScale;
+        if (!readDecimal(text, whole, fraction, fractionScale)) return false;
+
+        std::size_t unitLength = 0;
+        while (unitLength < text.size() && (text[unitLength] < '0' || text[unitLength] > '9') && text[unitLength] != '.') ++unitLength;
+        std::string_view unitName = text.substr(0, unitLength);
+        text.remove_prefix(unitLength);
+
+        auto unit = std::find_if(units.begin(), units.end(), [unitName](auto& u) { return u.first == unitName; });
+        if (unit == units.end()) return false;
+
+        std::uint64_t part;
+        if (!scaleDecimal(whole, fraction, fractionScale, unit->second, limit, part)) return false;
+        if (total > limit - part) return false;
+        total += part;
+    }
+    duration = std::chrono::nanoseconds(total);
+    return true;
+}
+
+/**
+ * @brief Parse a byte size like "4096", "4KiB", "1.5G" or "10MB".
+ * 
+ * K, M, G, T, P and E as well as KiB, MiB, ... are powers of 1024. KB, MB, ... are powers of 1000. B or no unit are bytes.
+ * A fraction is only allowed if the size is a whole number of bytes, like "1.5K" but not "1.5" or "0.1K".
+ * 
+ * @param text The text to parse.
+ * @param bytes Set to the parsed size on success.
+ * @return false if text is no valid byte size, no whole number of bytes or does not fit into std::uint64_t.
+ */
+bool parseByteSize(std::string_view text, std::uint64_t& bytes) {
+    std::uint64_t whole, fraction, fractionScale;
+    if (!readDecimal(text, whole, fraction, fractionScale)) return false;
+
+    std::uint64_t unit = 1;
+    if (!text.empty() && text != "B") {
+        static constexpr std::string_view prefixes = "KMGTPE";
+        std::size_t power = prefixes.find(text.front());
+        if (power == std::string_view::npos) return false;
+        std::string_view suffix = text.substr(1);
+        std::uint64_t base;
+        if (suffix.empty() || suffix == "iB") base = 1024;
+        else if (suffix == "B") base = 1000;
+        else return false;
+        for (std::size_t i = 0; i <= power; ++i) unit *= base;
+    }
+    // fraction < fractionScale <= 10^9, so the product cannot overflow.
+    if (fraction * (unit % fractionScale) % fractionScale != 0) return false;
+    std::uint64_t result;
+    if (!scaleDecimal(whole, fraction, fractionScale, unit, std::numeric_limits<std::uint64_t>::max(), result)) return false;
+    bytes = result;
+    return true;
+}
+
+
+/**
+ * @brief Check if a hand can never be typed as a single argument, because it is empty or contains whitespace.
+ */
+constexpr bool isBlankHand(std::string_view hand) {
+    return hand.empty() || hand.find_first_of(" \t\n\r\v\f") != std::string_view::npos;
+}
+
+
+/**
+ * @brief Return the length of the run of ASCII characters at the start of data. Checks 32 bytes at once with AVX2, 16 with SSE2 and 8 otherwise.
+ */
+std::size_t asciiPrefixLength(const char* data, std::size_t size) {
+    std::size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 32 <= size; i += 32) {
+        unsigned mask = unsigned(_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i))));
+        if (mask) return i + std::countr_zero(mask);
+    }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+    for (; i + 16 <= size; i += 16) {
+        unsigned mask = unsigned(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i))));
+        if (mask) return i + std::countr_zero(mask);
+    }
+#endif
+    for (; i + 8 <= size; i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        if (word & 0x8080808080808080ull) break;
+    }
+    while (i < size && static_cast<unsigned char>(data[i]) < 0x80) ++i;
+    return i;
+}
+
+/**
+ * @brief Find the first byte which is not part of valid UTF-8. Overlong encodings, surrogates and code points above U+10FFFF are invalid.
+ * 
+ * Runs of ASCII characters are skipped with asciiPrefixLength(), so mostly ASCII text costs little more than its length divided by the vector width.
+ * 
+ * @param text The text to check.
+ * @return std::size_t Offset of the first invalid byte or std::string_view::npos if text is valid UTF-8.
+ */
+std::size_t findInvalidUtf8(std::string_view text) {
+    const auto* data = reinterpret_cast<const unsigned char*>(text.data());
+    std::size_t size = text.size();
+    std::size_t i = 0;
+    while (i < size) {
+        i += asciiPrefixLength(text.data() + i, size - i);
+        if (i == size) break;
+
+        unsigned char lead = data[i];
+        std::size_t length;
+        unsigned char low = 0x80, high = 0xBF;
+        if (lead >= 0xC2 && lead <= 0xDF) length = 2;
+        else if (lead == 0xE0) { length = 3; low = 0xA0; }
+        else if (lead == 0xED) { length = 3; high = 0x9F; }
+        else if (lead >= 0xE1 && lead <= 0xEF) length = 3;
+        else if (lead == 0xF0) { length = 4; low = 0x90; }
+        else if (lead == 0xF4) { length = 4; high = 0x8F; }
+        else if (lead >= 0xF1 && lead <= 0xF3) length = 4;
+        else return i;
+
+        if (i + length > size) return i;
+        if (data[i + 1] < low || data[i + 1] > high) return i;
+        for (std::size_t j = 2; j < length; ++j) {
+            if (data[i + j] < 0x80 || data[i + j] > 0xBF) return i;
+        }
+        i += length;
+    }
+    return std::string_view::npos;
+}
+
+/**
+ * @brief Check if text is valid UTF-8.
+ */
+bool isValidUtf8(std::string_view text) {
+    return findInvalidUtf8(text) == std::string_view::npos;
+}
+
+
+/**
+ * @brief Convert the text following the hand of an Option into its value. Nothing is written to the variable of the Option.
+ * 
+ * @param text The argument following the hand.
+ * @param value Set to the converted value on success.
+ * @return std::string Empty on success, otherwise the error message.
+ */
+std::string Option::convertValue(std::string_view text, OptionValue& value) const {
+    auto error = [text](const std::string& expected) {
+        std::ostringstream oserr;
+        oserr << "ERROR: Expected " << expected << ", but got: " << text;
+        return oserr.str();
+    };
+    switch (_type) {
+    case STRING:
+        value = text;
+        return "";
+
+    case INT:
+        try {
+            value = std::stoi(std::string(text));
+        } catch (...) {
+            return error("type >>int<<");
+        }
+        return "";
+
+    case DOUBLE:
+        try {
+            value = std::stod(std::string(text));
+        } catch (...) {
+            return error("type >>double<<");
+        }
+        return "";
+
+    case DURATION: {
+        std::chrono::nanoseconds duration;
+        if (!parseDuration(text, duration)) return error("type >>duration<<");
+        value = duration;
+        return "";
+    }
+
+    case BYTES: {
+        std::uint64_t bytes;
+        if (!parseByteSize(text, bytes)) return error("type >>byte size<<");
+        value = bytes;
+        return "";
+    }
+
+    case CHOICE: {
+        std::size_t index = findChoice(text);
+        if (index == getChoiceCount()) return error("one of >>" + getChoiceList() + "<<");
+        value = ChoiceIndex{index};
+        return "";
+    }
+
+    default:
+        return "ERROR: unknown parsing from string to <type>";
+    }
+}
+
+/**
+ * @brief Write a value to the variable of the Option or hand it to its callback.
+ * 
+ * @param value The value from convertValue(), std::monostate for flags.
+ * @param self The CmdParserFrame handed to lambda flags.
+ */
+void Option::applyValue(const OptionValue& value, void* self) {
+    if (_callback) {
+        _callback(value);
+        return;
+    }
+    switch (_type) {
+    case BOOL: *pointerBool = true; break;
+    case LAMBDA: flagLambda(self); break;
+    case STRING: *pointerString = std::get<std::string_view>(value); break;
+    case INT: *pointerInt = std::get<int>(value); break;
+    case DOUBLE: *pointerDouble = std::get<double>(value); break;
+    case DURATION: *pointerDuration = std::get<std::chrono::nanoseconds>(value); break;
+    case BYTES: *pointerBytes = std::get<std::uint64_t>(value); break;
+    case CHOICE: assignChoice(std::get<ChoiceIndex>(value).index); break;
+    }
+}
+
+
+/* ============================================================================================================================== */
+
+/**
+ * Minimal C++20 generator. Values are produced lazily, one per increment of the iterator.
+ * A yielded value stays valid until the generator is resumed.
+ */
+template<typename T>
+class Generator {
+public:
+    struct promise_type {
+        T* current = nullptr;
+        std::exception_ptr exception;
+
+        Generator get_return_object() { return Generator(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(T& value) noexcept { current = std::addressof(value); return {}; }
+        void return_void() {}
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    class iterator {
+    private:
+        std::coroutine_handle<promise_type> _handle;
+
+    public:
+        explicit iterator(std::coroutine_handle<promise_type> handle) : _handle(handle) {}
+
+        iterator& operator++() {
+            _handle.resume();
+            if (_handle.promise().exception) std::rethrow_exception(_handle.promise().exception);
+            return *this;
+        }
+
+        T& operator*() const { return *_handle.promise().current; }
+        T* operator->() const { return _handle.promise().current; }
+        bool operator==(std::default_sentinel_t) const { return _handle.done(); }
+    };
+
+    explicit Generator(std::coroutine_handle<promise_type> handle) : _handle(handle) {}
+    Generator(Generator&& other) noexcept : _handle(std::exchange(other._handle, {})) {}
+    Generator(const Generator&) = delete;
+    Generator& operator=(const Generator&) = delete;
+    ~Generator() { if (_handle) _handle.destroy(); }
+
+    iterator begin() {
+        iterator it(_handle);
+        return ++it;
+    }
+
+    std::default_sentinel_t end() { return {}; }
+
+private:
+    std::coroutine_handle<promise_type> _handle;
+};
+
+enum EventKind {SUBCOMMAND_ENTERED, OPTION_MATCHED, VALUE_CONVERTED, POSITIONAL, PARSE_ERROR, BUILT_IN_MATCHED, PASSTHROUGH, HELP_TERM};
+
+/**
+ * A single step of parsing, yielded by CmdParserFrame::events().
+ * 
+ * SUBCOMMAND_ENTERED: token names the SubCommand, command is its index.
+ * OPTION_MATCHED:     token is a hand of option. Flags are complete with this event, other Options are followed by VALUE_CONVERTED if a value follows.
+ * VALUE_CONVERTED:    token is the value of option, value holds it converted. Nothing has been written to the variable of the Option yet.
+ * POSITIONAL:         token is neither a hand nor a SubCommand.
+ * PARSE_ERROR:        token could not be converted for option, error holds the message. Parsing continues with the next token.
+ * BUILT_IN_MATCHED:   token is a hand of builtIn, one of BUILT_IN_OPTIONS like -h or --license.
+ * PASSTHROUGH:        token is the first positional or "--" in a command with a passthrough tail. The tail starts at position,
+ *                     which is the position of token or the one after "--". This is the last event.
+ *                     Unknown tokens starting with "-" are POSITIONAL even there, as they are probably mistyped hands.
+ * HELP_TERM:          token directly follows -h or --help and is no hand, it is the term for searchHelp(). builtIn is the help flag.
+ */
+struct ArgumentEvent {
+    EventKind kind;
+    std::size_t position;
+    std::string_view token;
+    std::size_t command = 0;
+    Option* option = nullptr;
+    OptionValue value;
+    std::string error;
+    const OptionSpec* builtIn = nullptr;
+};
+
+
+/* ============================================================================================================================== */
+
+/**
+ * Cache of parsed command lines, see CmdParserFrame::digest(ParseCache&).
+ * 
+ * An entry stores the converted values of one command line. Entries are found by a hash of the arguments and a fingerprint of the
+ * Options and SubCommands of the parser, so one cache can be shared by every parser built from the same schema.
+ * Holds at most capacity entries and evicts the least recently used one.
+ */
+class ParseCache {
+private:
+    friend class CmdParserFrame;
+
+    /// @brief One write of a cached parse. option is the index of the Option in its command.
+    struct Step {
+        EventKind kind;
+        std::size_t command;
+        std::size_t option;
+        std::size_t position;
+        OptionValue value;
+    };
+
+    struct Entry {
+        std::uint64_t key;
+        std::uint64_t fingerprint;
+        std::string arguments;
+        std::vector<Step> steps;
+    };
+
+    std::size_t _capacity;
+    std::size_t _hits = 0;
+    std::size_t _misses = 0;
+    std::list<Entry> _entries;
+    std::unordered_map<std::uint64_t, std::list<Entry>::iterator> _index;
+
+    static std::uint64_t hash(std::uint64_t seed, std::span<char*> arguments);
+    static std::string join(std::span<char*> arguments);
+    const Entry* find(std::uint64_t key, std::uint64_t fingerprint, std::span<char*> arguments);
+    void insert(Entry entry);
+
+public:
+    explicit ParseCache(std::size_t capacity = 256) : _capacity(capacity) {}
+
+    std::size_t hits() const { return _hits; }
+    std::size_t misses() const { return _misses; }
+    std::size_t size() const { return _entries.size(); }
+    std::size_t capacity() const { return _capacity; }
+    void clear();
+};
+
+/**
+ * @brief FNV-1a hash of the arguments. Every argument is hashed with its terminating null, so "ab" "c" and "a" "bc" differ.
+ */
+std::uint64_t ParseCache::hash(std::uint64_t seed, std::span<char*> arguments) {
+    std::uint64_t hash = seed;
+    for (char* argument : arguments) {
+        const char* c = argument;
+        do {
+            hash ^= (unsigned char) *c;
+            hash *= 0x100000001b3ull;
+        } while (*c++);
+    }
+    return hash;
+}
+
+/**
+ * @brief Join the arguments, each followed by its terminating null, to compare them with the arguments of an entry.
+ */
+std::string ParseCache::join(std::span<char*> arguments) {
+    std::string joined;
+    for (char* argument : arguments) joined.append(argument, std::strlen(argument) + 1);
+    return joined;
+}
+
+/**
+ * @brief Find the entry of the arguments and mark it as most recently used. Counts a hit or a miss.
+ * 
+ * @return const Entry* nullptr if the arguments are not cached.
+ */
+const ParseCache::Entry* ParseCache::find(std::uint64_t key, std::uint64_t fingerprint, std::span<char*> arguments) {
+    auto found = _index.find(key);
+    if (found != _index.end() && found->second->fingerprint == fingerprint) {
+        std::string_view cached = found->second->arguments;
+        bool equal = true;
+        for (char* argument : arguments) {
+            std::size_t length = std::strlen(argument) + 1;
+            if (cached.size() < length || cached.substr(0, length) != std::string_view(argument, length)) {
+                equal = false;
+                break;
+            }
+            cached.remove_prefix(length);
+        }
+        if (equal && cached.empty()) {
+            _entries.splice(_entries.begin(), _entries, found->second);
+            ++_hits;
+            return &_entries.front();
+        }
+    }
+    ++_misses;
+    return nullptr;
+}
+
+/**
+ * @brief Insert an entry as most recently used, replacing an entry of the same key and evicting the least recently used one if full.
+ */
+void ParseCache::insert(Entry entry) {
+    if (_capacity == 0) return;
+    auto found = _index.find(entry.key);
+    if (found != _index.end()) {
+        _entries.erase(found->second);
+        _index.erase(found);
+    }
+    if (_entries.size() >= _capacity) {
+        _index.erase(_entries.back().key);
+        _entries.pop_back();
+    }
+    _entries.push_front(std::move(entry));
+    _index[_entries.front().key] = _entries.begin();
+}
+
+/**
+ * @brief Remove all entries. The counters are kept.
+ */
+void ParseCache::clear() {
+    _entries.clear();
+    _index.clear();
+}
+
 
 /* ============================================================================================================================== */
 
+/// @brief A row of the usage found by CmdParserFrame::searchHelp().
+struct HelpMatch {
+    std::string path;                   ///< The command the row is printed for, like "program sub".
+    std::vector<std::string> hands;     ///< The hands of the Option or the name of the SubCommand.
+    std::string description;
+    bool isSubCommand = false;
+};
+
+/// @brief A problem found by CmdParserFrame::validate(). position is the index of the argument, like for argv.
+struct Diagnostic {
+    std::size_t position;
+    std::string message;
+};
+
+/// @brief Result of CmdParserFrame::validate().
+struct ValidationResult {
+    std::string path;                       ///< The command the arguments resolve to, like "program sub".
+    std::vector<Diagnostic> diagnostics;    ///< Everything digest() would reject, in order. Empty if the arguments are valid.
+    std::size_t passthroughPosition = 0;    ///< Position of the first argument of the passthrough tail, 0 if there is none.
+
+    bool isValid() const { return diagnostics.empty(); }
+};
+
+
 /**
  * Class for parsing command line arguments.
  * 
@@ -135,20 +961,87 @@ std::vector<std::string> Option::getAnonymousHands() {
  * These lists are then on creation of this class used to parse argc and argv arguments of the main class.
  * This class also includes pretty print capabilities of said Flags and Options.
  * SubCommands should not print license.
+ * 
+ * The whole tree of SubCommands is flattened into one array when the parser is constructed from argc and argv.
+ * Until then a SubCommand only holds its own Options and its SubCommands. Printing or searching it on its own flattens its tree first.
  */
 class CmdParserFrame {
 private:
-    int _argc;
-    char** _argv;
+    static constexpr std::size_t NO_PARENT = std::size_t(-1);
+
+    /// @brief A single command of the tree. Links to other commands are indices into _nodes.
+    struct CommandNode {
+        std::string commandName;
+        std::string subCommandDescription;
+        std::string_view staticHelp;
+        bool* wasCommandCalled = nullptr;
+        std::span<char*>* passthroughTail = nullptr;
+        std::span<const OptionSpec> builtIns;
+        std::vector<Option> options;
+        std::size_t parent = NO_PARENT;
+        std::vector<std::size_t> subCommands;
+        std::vector<std::size_t> sortedSubCommands;
+    };
+
+    /// @brief A row of the usage of a command: an Option, a built in flag or a SubCommand. text is what searchHelp() matches, in lower case.
+    struct HelpRow {
+        std::size_t command;
+        std::size_t option = NO_PARENT;
+        const OptionSpec* builtIn = nullptr;
+        std::size_t subCommand = NO_PARENT;
+        std::string text;
+    };
+
+    /// @brief The rows of all commands and for every trigram of their text the sorted indices of the rows containing it.
+    struct HelpIndex {
+        std::vector<HelpRow> rows;
+        std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> trigrams;
+    };
+
+    /// @brief Resets the active command to the root when parsing returns or throws, so printAll() and searchHelp() start at the root again.
+    struct ActiveNodeReset {
+        std::size_t& activeNode;
+        ~ActiveNodeReset() { activeNode = 0; }
+    };
+
+    /// @brief A SubCommand waiting to be flattened into the tree of the CmdParser it is given to. Shared, so copies of a SubCommand are cheap.
+    struct PendingCommand {
+        CommandNode node;
+        std::vector<CmdParserFrame> subCommands;
+    };
+
+    int _argc = 1;
+    char** _argv = nullptr;
 
-    std::string _commandName;
     std::string _subCommandUsageHeader;
     std::string _programDescription;
-    std::string _subCommandDescription;
-    std::string _subCommandCascadeString;
-    bool* _wasCommandCalled;
-    std::vector<CmdParserFrame> _subCommands;
-    std::list<Option> _options;
+    std::string _licenseText;
+    std::vector<CommandNode> _nodes;
+    std::size_t _activeNode = 0;
+    std::shared_ptr<const PendingCommand> _pending;
+    bool _utf8Validation = false;
+    std::uint64_t _fingerprint = 0;
+    std::shared_ptr<const HelpIndex> _helpIndex;
+    std::shared_ptr<const std::string> _schema;
+
+    void buildTree(CommandNode root, std::vector<CmdParserFrame>& subCommands);
+    void buildPendingTree();
+    void appendSubCommand(const CmdParserFrame& subCommand, std::size_t parent);
+    std::size_t findSubCommand(std::size_t node, std::string_view name);
+    std::string getCascadeString(std::size_t node);
+    static std::string_view getCommandName(const CmdParserFrame& frame);
+    bool printStaticHelp();
+    static void checkHands(const CommandNode& node, const std::vector<std::string_view>& subCommandNames);
+    void enterCommand(std::size_t command);
+    static const OptionSpec* findBuiltIn(const CommandNode& node, std::string_view token);
+    void runBuiltIn(std::size_t builtIn);
+    void digestEvents(std::vector<ParseCache::Step>* steps);
+    void computeFingerprint();
+    std::uint64_t getFingerprint();
+    std::span<char*> getArguments();
+    const HelpIndex& getHelpIndex();
+    template<typename Writer>
+    void writeSchema(Writer& out, std::size_t node);
 
 public:
     CmdParserFrame(int argc, char* argv[],
@@ -162,25 +1055,46 @@ public:
         std::string subCommandUsageHeader = "",
         std::string programDescription = "",
         std::string licenseText = "",
-        std::vector<CmdParserFrame> subCommands = {}
+        std::vector<CmdParserFrame> subCommands = {},
+        std::string_view staticHelp = {}
         );
 
     CmdParserFrame(std::list<Option> options,
             std::string commandName,
             bool* wasCommandCalled = nullptr,
             std::vector<CmdParserFrame> subCommands = {},
-            std::string commandDescription = ""
+            std::string commandDescription = "",
+            std::string_view staticHelp = {},
+            std::span<char*>* passthroughTail = nullptr
             );
 
     void digest();
+    void digest(ParseCache& cache);
     void comfortDigest();
+    void comfortDigest(ParseCache& cache);
     bool isEmpty();
-    void printOptions(int spaces = SPACES, std::string prefix = "", std::function<bool(Type)> include = [](Type a){return true;});
-    void printAll(int spaces = SPACES, bool andExit = false);
+    void printOptions(int spaces = SPACES, std::string prefix = "", std::function<bool(Type)> include = [](Type a){return true;}, std::ostream& out = std::cout);
+    void printAll(int spaces = SPACES, bool andExit = false, std::ostream& out = std::cout);
+    void checkHands();
+    void checkStaticHelp();
+    void setUtf8Validation(bool enable = true);
+    void checkUtf8();
+    std::vector<HelpMatch> searchHelp(std::string_view term);
+    void printSearch(std::string_view term, int spaces = SPACES);
+    std::string_view exportSchema();
 
-    friend class CmdParserFrame;
+    Generator<ArgumentEvent> events();
+
+    template<typename Tokens>
+    Generator<ArgumentEvent> events(Tokens tokens);
+
+    ValidationResult validate();
+
+    template<typename Tokens>
+    ValidationResult validate(Tokens tokens);
 };
 
+
 /// @brief Class to call in CmdParser for subcommands.
 class SubCommand : public CmdParserFrame {
     public:
@@ -188,8 +1102,10 @@ class SubCommand : public CmdParserFrame {
         std::string commandName,
         bool* wasCommandCalled = nullptr,
         std::vector<CmdParserFrame> subCommands = {},
-        std::string commandDescription = ""
-        ) : CmdParserFrame(options, commandName, wasCommandCalled, subCommands, commandDescription) {}
+        std::string commandDescription = "",
+        std::string_view staticHelp = {},
+        std::span<char*>* passthroughTail = nullptr
+        ) : CmdParserFrame(std::move(options), std::move(commandName), wasCommandCalled, std::move(subCommands), std::move(commandDescription), staticHelp, passthroughTail) {}
 };
 
 /// @brief Class to call in your main function.
@@ -201,8 +1117,9 @@ class CmdParser : public CmdParserFrame {
         std::string subCommandUsageHeader = "",
         std::string programDescription = "",
         std::string licenseText = "",
-        std::vector<CmdParserFrame> subCommands = {}
-        ) : CmdParserFrame(argc, argv, options, programName, subCommandUsageHeader, programDescription, licenseText, subCommands) {}
+        std::vector<CmdParserFrame> subCommands = {},
+        std::string_view staticHelp = {}
+        ) : CmdParserFrame(argc, argv, std::move(options), std::move(programName), std::move(subCommandUsageHeader), std::move(programDescription), std::move(licenseText), std::move(subCommands), staticHelp) {}
 };
 
 
@@ -220,8 +1137,13 @@ CmdParserFrame::CmdParserFrame(int argc, char* argv[],
                     std::list<Option> options,
                     std::vector<CmdParserFrame> subCommands
                     )
-    : _argc(argc), _argv(argv), _options(options), _subCommands(subCommands), _commandName("program"), _wasCommandCalled(nullptr), _subCommandCascadeString("program"), _subCommandUsageHeader("")
-{}
+    : _argc(argc), _argv(argv), _subCommandUsageHeader("")
+{
+    CommandNode root;
+    root.commandName = "program";
+    root.options.assign(std::make_move_iterator(options.begin()), std::make_move_iterator(options.end()));
+    buildTree(std::move(root), subCommands);
+}
 
 
 /**
@@ -235,6 +1157,7 @@ CmdParserFrame::CmdParserFrame(int argc, char* argv[],
  * @param programDescription Description and usage displayed by your programs --help flag.
  * @param licenseText Text displayed for flag --license.
  * @param subCommands Array of CmdParser which will act as subcommands.
+ * @param staticHelp Help text rendered at compile time by renderHelp(), printed instead of the runtime help. Must outlive the parser.
  */
 CmdParserFrame::CmdParserFrame(int argc, char* argv[],
                     std::list<Option> options,
@@ -242,22 +1165,18 @@ CmdParserFrame::CmdParserFrame(int argc, char* argv[],
                     std::string subCommandUsageHeader,
                     std::string programDescription,
                     std::string licenseText,
-                    std::vector<CmdParserFrame> subCommands
+                    std::vector<CmdParserFrame> subCommands,
+                    std::string_view staticHelp
                     )
-    : _argc(argc), _argv(argv), _options(options), _commandName(programName), _subCommandUsageHeader(subCommandUsageHeader), _programDescription(programDescription), _subCommands(subCommands), _wasCommandCalled(nullptr), _subCommandCascadeString(programName)
+    : _argc(argc), _argv(argv), _subCommandUsageHeader(std::move(subCommandUsageHeader)), _programDescription(std::move(programDescription)), _licenseText(std::move(licenseText))
 {
-    auto printHelp = [=](void* self){
-        std::cout << ((CmdParserFrame*) self)->_programDescription << std::endl;
-        ((CmdParserFrame*) self)->printAll();
-        exit(0);
-    };
-    auto printLicense = [=](void* self){
-        std::cout << licenseText << "\n" << LICENSENOTICE << std::endl;
-        exit(0);
-    };
-    _options.push_front(Option(printLicense, {"--license"}, "Print licenses.", {"--License", "/License", "/license"}));
-    _options.push_front(Option(printHelp, {"-h", "--help"}, "Show this message.", {"/h"}));
-    if (this->isEmpty()) printHelp(this);
+    CommandNode root;
+    root.commandName = std::move(programName);
+    root.staticHelp = staticHelp;
+    root.builtIns = BUILT_IN_OPTIONS;
+    root.options.assign(std::make_move_iterator(options.begin()), std::make_move_iterator(options.end()));
+    buildTree(std::move(root), subCommands);
+    if (this->isEmpty()) runBuiltIn(0);
 }
 
 
@@ -269,21 +1188,145 @@ CmdParserFrame::CmdParserFrame(int argc, char* argv[],
  * @param wasCommandCalled Pointer to bool, which will be set to true if the subcommand is the subcommand called.
  * @param subCommands SubCommands of this SubCommand. If one of them is called => !wasCommandCalled
  * @param commandDescription Description of SubCommand printed by printAll().
+ * @param staticHelp Help text rendered at compile time by renderHelp(), printed instead of the runtime help. Must outlive the parser.
+ * @param passthroughTail If given, parsing of this SubCommand stops at the first positional argument or after "--", and the rest of argv is stored in it.
+ *                        Unknown arguments starting with "-" are still rejected, pass them after "--".
+ *                        Empty if there is no rest. Points into argv, so it can be passed to execvp as is.
  */
 CmdParserFrame::CmdParserFrame(std::list<Option> options,
                     std::string commandName,
                     bool* wasCommandCalled,
                     std::vector<CmdParserFrame> subCommands,
-                    std::string commandDescription
+                    std::string commandDescription,
+                    std::string_view staticHelp,
+                    std::span<char*>* passthroughTail
                     )
-                    : _options(options), _commandName(commandName), _wasCommandCalled(wasCommandCalled), _subCommands(subCommands), _subCommandDescription(commandDescription) 
 {
-    auto printHelp = [&](void* self){
-        std::cout << ((CmdParserFrame*) self)->_subCommandUsageHeader << std::endl;
-        ((CmdParserFrame*) self)->printAll();
-        exit(0);
-    };
-    _options.push_front(Option(printHelp, {"-h", "--help"}, "Show this message.", {"/h"}));
+    auto pending = std::make_shared<PendingCommand>();
+    pending->node.commandName = std::move(commandName);
+    pending->node.subCommandDescription = std::move(commandDescription);
+    pending->node.staticHelp = staticHelp;
+    pending->node.wasCommandCalled = wasCommandCalled;
+    pending->node.passthroughTail = passthroughTail;
+    pending->node.builtIns = std::span<const OptionSpec>(BUILT_IN_OPTIONS).first(1);
+    pending->node.options.assign(std::make_move_iterator(options.begin()), std::make_move_iterator(options.end()));
+    pending->subCommands = std::move(subCommands);
+#ifndef NDEBUG
+    std::vector<std::string_view> subCommandNames;
+    for (auto& subCommand : pending->subCommands) subCommandNames.push_back(getCommandName(subCommand));
+    checkHands(pending->node, subCommandNames);
+#endif
+    _pending = std::move(pending);
+}
+
+
+/**
+ * @brief Flatten root and its SubCommands into _nodes. Every node is copied exactly once, however deep the tree is.
+ * 
+ * @param root The node of this command.
+ * @param subCommands The SubCommands given to the constructor.
+ */
+void CmdParserFrame::buildTree(CommandNode root, std::vector<CmdParserFrame>& subCommands) {
+    _nodes.push_back(std::move(root));
+    for (auto& subCommand : subCommands) appendSubCommand(subCommand, 0);
+
+    for (auto& node : _nodes) {
+        node.sortedSubCommands = node.subCommands;
+        std::sort(node.sortedSubCommands.begin(), node.sortedSubCommands.end(), [this](std::size_t a, std::size_t b) {
+            return _nodes[a].commandName < _nodes[b].commandName;
+        });
+    }
+#ifndef NDEBUG
+    // Every SubCommand checked its own node when it was constructed, so only the root is left.
+    if (!_pending) {
+        std::vector<std::string_view> subCommandNames;
+        for (auto subCommand : _nodes[0].subCommands) subCommandNames.push_back(_nodes[subCommand].commandName);
+        checkHands(_nodes[0], subCommandNames);
+        checkStaticHelp();
+    }
+#endif
+}
+
+/**
+ * @brief Flatten the tree of a SubCommand not yet given to a CmdParser, so it can be printed, searched and checked on its own.
+ * Does nothing if the tree is already flat.
+ */
+void CmdParserFrame::buildPendingTree() {
+    if (!_nodes.empty() || !_pending) return;
+    std::vector<CmdParserFrame> subCommands = _pending->subCommands;
+    buildTree(_pending->node, subCommands);
+}
+
+/**
+ * @brief Append a SubCommand and all of its SubCommands to _nodes, depth first.
+ * 
+ * @param subCommand A SubCommand, or a CmdParserFrame whose tree is already flat.
+ * @param parent Index of the node the SubCommand belongs to.
+ */
+void CmdParserFrame::appendSubCommand(const CmdParserFrame& subCommand, std::size_t parent) {
+    std::size_t index = _nodes.size();
+    _nodes[parent].subCommands.push_back(index);
+
+    if (subCommand._pending) {
+        _nodes.push_back(subCommand._pending->node);
+        _nodes[index].parent = parent;
+        for (auto& child : subCommand._pending->subCommands) appendSubCommand(child, index);
+        return;
+    }
+
+    for (auto& node : subCommand._nodes) {
+        _nodes.push_back(node);
+        CommandNode& copy = _nodes.back();
+        copy.parent = copy.parent == NO_PARENT ? parent : copy.parent + index;
+        for (auto& child : copy.subCommands) child += index;
+    }
+}
+
+/**
+ * @brief Look up a SubCommand of node by name. Binary search, without allocations.
+ * 
+ * @return std::size_t Index of the SubCommand in _nodes or NO_PARENT if node has no SubCommand of that name.
+ */
+std::size_t CmdParserFrame::findSubCommand(std::size_t node, std::string_view name) {
+    auto& sorted = _nodes[node].sortedSubCommands;
+    auto found = std::lower_bound(sorted.begin(), sorted.end(), name, [this](std::size_t a, std::string_view b) {
+        return _nodes[a].commandName < b;
+    });
+    if (found == sorted.end() || _nodes[*found].commandName != name) return NO_PARENT;
+    return *found;
+}
+
+/**
+ * @brief Return the names of all commands from the root to node, separated by spaces. Example: "program sub subsub".
+ */
+std::string CmdParserFrame::getCascadeString(std::size_t node) {
+    std::vector<std::size_t> path;
+    for (std::size_t i = node; i != NO_PARENT; i = _nodes[i].parent) path.push_back(i);
+    std::string cascade;
+    for (auto i = path.rbegin(); i != path.rend(); ++i) {
+        if (!cascade.empty()) cascade += " ";
+        cascade += _nodes[*i].commandName;
+    }
+    return cascade;
+}
+
+/**
+ * @brief Return the name of the command a frame was constructed for.
+ */
+std::string_view CmdParserFrame::getCommandName(const CmdParserFrame& frame) {
+    return frame._pending ? frame._pending->node.commandName : frame._nodes[0].commandName;
+}
+
+/**
+ * @brief Print the help text rendered at compile time of the active command, if it has one.
+ * 
+ * @return true if a static help text was printed.
+ */
+bool CmdParserFrame::printStaticHelp() {
+    std::string_view staticHelp = _nodes[_activeNode].staticHelp;
+    if (staticHelp.empty()) return false;
+    std::cout.write(staticHelp.data(), staticHelp.size()).flush();
+    return true;
 }
 
 
@@ -293,87 +1336,501 @@ CmdParserFrame::CmdParserFrame(std::list<Option> options,
  * @throws std::invalid_argument if invalid integer is parsed for option of integer type.
  * @throws std::invalid_argument if invalid double is parsed for option of double type.
  * @throws std::invalid_argument if invalid type n > 3 OR n < 1 is given in form of an option.
+ * @throws std::invalid_argument if an argument is not valid UTF-8 and setUtf8Validation() was enabled.
  */
 void CmdParserFrame::digest() {
     if (this->isEmpty()) return;
+    if (_utf8Validation) checkUtf8();
+    digestEvents(nullptr);
+}
+
+/**
+ * @brief Parse command line arguments like digest(), but look them up in cache first.
+ * 
+ * On a hit the converted values stored in cache are written to the variables and callbacks of this parser directly,
+ * without matching hands or converting values again. On a miss the arguments are parsed with digest() and stored in cache if they are valid.
+ * 
+ * @param cache Cache shared by parsers of the same Options and SubCommands.
+ * @throws std::invalid_argument like digest().
+ */
+void CmdParserFrame::digest(ParseCache& cache) {
+    if (this->isEmpty()) return;
 
-    if (_argc >= 2){
-        for (auto& subCommand : _subCommands) {       
-            if (std::string(*(_argv + 1)) == subCommand._commandName) {
-                if (subCommand._wasCommandCalled) { *(subCommand._wasCommandCalled) = true; }
-                if (_wasCommandCalled) { *_wasCommandCalled = false; }
-                subCommand._argc = _argc - 1;
-                subCommand._argv = _argv + 1;
-                subCommand._subCommandCascadeString = _subCommandCascadeString + " " + subCommand._commandName;
-                subCommand._subCommandUsageHeader = _subCommandUsageHeader;
-                subCommand.digest();
-                return;
+    std::span<char*> arguments = getArguments();
+    std::uint64_t fingerprint = getFingerprint();
+    std::uint64_t key = ParseCache::hash(fingerprint, arguments);
+
+    if (const ParseCache::Entry* entry = cache.find(key, fingerprint, arguments)) {
+        _activeNode = 0;
+        ActiveNodeReset reset {_activeNode};
+        for (auto& step : entry->steps) {
+            if (step.kind == SUBCOMMAND_ENTERED) {
+                enterCommand(step.command);
+                continue;
             }
+            if (step.kind == PASSTHROUGH) {
+                *(_nodes[step.command].passthroughTail) = std::span<char*>(_argv + step.position, _argv + _argc);
+                continue;
+            }
+            Option& option = _nodes[step.command].options[step.option];
+            if (std::holds_alternative<std::string_view>(step.value)) {
+                // Cached string values point into the argv they were parsed from.
+                option.applyValue(std::string_view(_argv[step.position]), (void*) this);
+            } else {
+                option.applyValue(step.value, (void*) this);
+            }
+        }
+        return;
+    }
+
+    if (_utf8Validation) checkUtf8();
+    std::vector<ParseCache::Step> steps;
+    digestEvents(&steps);
+    cache.insert({key, fingerprint, ParseCache::join(arguments), std::move(steps)});
+}
+
+/**
+ * @brief Mark command as called and the previously active command as not called. Clears the passthrough tail of command.
+ */
+void CmdParserFrame::enterCommand(std::size_t command) {
+    if (_nodes[command].wasCommandCalled) { *(_nodes[command].wasCommandCalled) = true; }
+    if (_nodes[_activeNode].wasCommandCalled) { *(_nodes[_activeNode].wasCommandCalled) = false; }
+    if (_nodes[command].passthroughTail) { *(_nodes[command].passthroughTail) = std::span<char*>(_argv + _argc, std::size_t(0)); }
+    _activeNode = command;
+}
+
+/**
+ * @brief Apply events() to the variables and callbacks of the Options.
+ * 
+ * @param steps If not nullptr, every write is recorded for ParseCache.
+ */
+void CmdParserFrame::digestEvents(std::vector<ParseCache::Step>* steps) {
+    _activeNode = 0;
+    ActiveNodeReset reset {_activeNode};
+    bool helpRequested = false;
+    for (auto& event : events()) {
+        // Help waits for the next token, which may be a search term.
+        if (helpRequested) {
+            if (event.kind == HELP_TERM) {
+                printSearch(event.token);
+                exit(0);
+            }
+            runBuiltIn(0);
+        }
+
+        switch (event.kind) {
+        case SUBCOMMAND_ENTERED:
+            enterCommand(event.command);
+            if (steps) steps->push_back({SUBCOMMAND_ENTERED, event.command, 0, event.position, {}});
+            break;
+
+        case OPTION_MATCHED:
+            if (event.option->getType() == BOOL || event.option->getType() == LAMBDA) {
+                if (steps) steps->push_back({OPTION_MATCHED, event.command, std::size_t(event.option - _nodes[event.command].options.data()), event.position, {}});
+                event.option->applyValue(std::monostate(), (void*) this);
+            }
+            break;
+
+        case VALUE_CONVERTED:
+            if (steps) steps->push_back({VALUE_CONVERTED, event.command, std::size_t(event.option - _nodes[event.command].options.data()), event.position, event.value});
+            event.option->applyValue(event.value, (void*) this);
+            break;
+
+        case POSITIONAL: {
+            std::ostringstream oserr;
+            oserr << "ERROR: Unkown argument: " << event.token;
+            throw std::invalid_argument( oserr.str() );
+        }
+
+        case PARSE_ERROR:
+            throw std::invalid_argument( event.error );
+
+        case BUILT_IN_MATCHED:
+            if (event.builtIn == &BUILT_IN_OPTIONS[0]) {
+                helpRequested = true;
+                break;
+            }
+            runBuiltIn(event.builtIn - BUILT_IN_OPTIONS.data());
+            break;
+
+        case PASSTHROUGH:
+            if (steps) steps->push_back({PASSTHROUGH, event.command, 0, event.position, {}});
+            *(_nodes[event.command].passthroughTail) = std::span<char*>(_argv + event.position, _argv + _argc);
+            break;
+
+        case HELP_TERM:
+            // Only follows --help, which is handled above.
+            break;
+        }
+    }
+    if (helpRequested) runBuiltIn(0);
+}
+
+/**
+ * @brief Return the built in flag of node which has token as hand.
+ * 
+ * @return const OptionSpec* nullptr if token is no hand of a built in flag.
+ */
+const OptionSpec* CmdParserFrame::findBuiltIn(const CommandNode& node, std::string_view token) {
+    for (auto& builtIn : node.builtIns) {
+        for (auto* hands : {&builtIn.hands, &builtIn.anonymousHands}) {
+            for (auto& hand : *hands) {
+                if (!hand.empty() && hand == token) return &builtIn;
+            }
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Run the built in flag with the given index into BUILT_IN_OPTIONS: print the help of the active command or the licenses and exit.
+ */
+void CmdParserFrame::runBuiltIn(std::size_t builtIn) {
+    if (builtIn == 0) {
+        if (printStaticHelp()) exit(0);
+        std::cout << (_activeNode == 0 ? _programDescription : _subCommandUsageHeader) << std::endl;
+        printAll();
+    } else {
+        std::cout << _licenseText << "\n" << LICENSENOTICE << std::endl;
+    }
+    exit(0);
+}
+
+/**
+ * @brief Hash everything that decides how arguments are parsed: the tree of commands, the types and hands of the Options and their choices.
+ * Without allocations, so parsers built per command line stay cheap on a cache hit.
+ */
+void CmdParserFrame::computeFingerprint() {
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    auto mixByte = [&](unsigned char c) {
+        hash ^= c;
+        hash *= 0x100000001b3ull;
+    };
+    auto mix = [&](std::string_view text) {
+        for (char c : text) mixByte((unsigned char) c);
+        mixByte(0xff);
+    };
+    auto mixNumber = [&](std::uint64_t number) {
+        for (int i = 0; i < 8; ++i) mixByte((unsigned char) (number >> (8 * i)));
+    };
+    for (auto& node : _nodes) {
+        mix(node.commandName);
+        mixNumber(node.parent);
+        mixNumber(node.builtIns.size());
+        mixByte(node.passthroughTail ? 1 : 0);
+        mixNumber(node.options.size());
+        for (auto& option : node.options) {
+            mixNumber(option.getType());
+            for (auto& hand : option.getHands()) mix(hand);
+            mix("");
+            for (auto& hand : option.getAnonymousHands()) mix(hand);
+            mix("");
+            for (std::size_t i = 0; i < option.getChoiceCount(); ++i) mix(option.getChoice(i));
+            mix("");
+        }
+    }
+    _fingerprint = hash ? hash : 1;
+}
+
+/**
+ * @brief The fingerprint of the tree, computed by computeFingerprint() on first use. Also depends on setUtf8Validation().
+ */
+std::uint64_t CmdParserFrame::getFingerprint() {
+    if (!_fingerprint) computeFingerprint();
+    if (!_utf8Validation) return _fingerprint;
+    return (_fingerprint ^ 0x75) * 0x100000001b3ull;
+}
+
+/**
+ * @brief The arguments given to the constructor without the program name.
+ */
+std::span<char*> CmdParserFrame::getArguments() {
+    if (_argc > 1 && _argv) return std::span<char*>(_argv + 1, _argv + _argc);
+    return {};
+}
+
+/**
+ * @brief Parse tokens step by step without writing any variable or calling any callback.
+ * 
+ * Tokens are taken one at a time, so tokens can be any input range, like a stream, of things convertible to std::string_view.
+ * The program name is not part of tokens, positions start at 1 like indices of argv.
+ * Stop iterating at any time to stop parsing.
+ * 
+ * @param tokens The arguments to parse.
+ * @return Generator<ArgumentEvent> The events in the order of the tokens.
+ */
+template<typename Tokens>
+Generator<ArgumentEvent> CmdParserFrame::events(Tokens tokens) {
+    buildPendingTree();
+    std::size_t command = 0;
+    bool atCommandStart = true;
+    std::unordered_map<std::string_view, Option*> hands;
+    Option* pending = nullptr;
+    const OptionSpec* pendingHelp = nullptr;
+    std::size_t position = 0;
+
+    // Yielded events are named locals, as GCC 12 destroys temporaries of aggregates in co_yield twice.
+    for (auto&& element : tokens) {
+        std::string_view token = element;
+        ++position;
+
+        if (atCommandStart) {
+            std::size_t subCommand = findSubCommand(command, token);
+            if (subCommand != NO_PARENT) {
+                command = subCommand;
+                ArgumentEvent event {SUBCOMMAND_ENTERED, position, token, command};
+                co_yield event;
+                continue;
+            }
+            atCommandStart = false;
+            for (auto& option : _nodes[command].options) {
+                for (auto& hand : option.getHands()) hands.insert({hand, &option});
+                for (auto& hand : option.getAnonymousHands()) hands.insert({hand, &option});
+            }
+        }
+
+        bool passthrough = _nodes[command].passthroughTail != nullptr;
+        if (passthrough && !pending && token == "--") {
+            ArgumentEvent event {PASSTHROUGH, position + 1, token, command};
+            co_yield event;
+            co_return;
+        }
+
+        const OptionSpec* builtIn = findBuiltIn(_nodes[command], token);
+        auto hand = hands.find(token);
+        if (pendingHelp && !builtIn && hand == hands.end()) {
+            ArgumentEvent event {HELP_TERM, position, token, command};
+            event.builtIn = pendingHelp;
+            pendingHelp = nullptr;
+            co_yield event;
+            continue;
+        }
+        pendingHelp = nullptr;
+        if (pending && !builtIn && hand == hands.end()) {
+            ArgumentEvent event {VALUE_CONVERTED, position, token, command, pending};
+            std::string error = pending->convertValue(token, event.value);
+            if (!error.empty()) {
+                event.kind = PARSE_ERROR;
+                event.error = std::move(error);
+            }
+            pending = nullptr;
+            co_yield event;
+            continue;
+        }
+        pending = nullptr;
+
+        if (builtIn) {
+            ArgumentEvent event {BUILT_IN_MATCHED, position, token, command};
+            event.builtIn = builtIn;
+            if (builtIn == &BUILT_IN_OPTIONS[0]) pendingHelp = builtIn;
+            co_yield event;
+            continue;
+        }
+        if (hand == hands.end()) {
+            // A token which looks like an option is more likely a typo than the start of the tail.
+            bool startsTail = passthrough && (token.size() < 2 || token[0] != '-');
+            ArgumentEvent event {startsTail ? PASSTHROUGH : POSITIONAL, position, token, command};
+            co_yield event;
+            if (startsTail) co_return;
+            continue;
+        }
+        Type type = hand->second->getType();
+        if (type != BOOL && type != LAMBDA) pending = hand->second;
+        ArgumentEvent event {OPTION_MATCHED, position, token, command, hand->second};
+        co_yield event;
+    }
+}
+
+/**
+ * @brief Parse the arguments given to the constructor step by step without writing any variable or calling any callback.
+ * 
+ * @return Generator<ArgumentEvent> The events in the order of the arguments.
+ */
+Generator<ArgumentEvent> CmdParserFrame::events() {
+    return events(getArguments());
+}
+
+/**
+ * @brief Check tokens without writing any variable or calling any callback, not even --help.
+ * 
+ * Unlike digest(), checking does not stop at the first problem, every token is checked.
+ * If setUtf8Validation() was enabled, every parsed token is checked for valid UTF-8 too.
+ * The passthrough tail is not parsed, so it is not checked here, validate() checks it.
+ * 
+ * @param tokens The arguments to check, like for events(tokens).
+ * @return ValidationResult The command the tokens resolve to and everything digest() would reject.
+ */
+template<typename Tokens>
+ValidationResult CmdParserFrame::validate(Tokens tokens) {
+    buildPendingTree();
+    ValidationResult result;
+    std::size_t command = 0;
+    for (auto& event : events(std::move(tokens))) {
+        if (_utf8Validation && event.kind != PASSTHROUGH) {
+            std::size_t offset = findInvalidUtf8(event.token);
+            if (offset != std::string_view::npos) {
+                std::ostringstream oserr;
+                oserr << "ERROR: Invalid UTF-8 in argument " << event.position << " at byte " << offset;
+                result.diagnostics.push_back({event.position, oserr.str()});
+            }
+        }
+
+        switch (event.kind) {
+        case SUBCOMMAND_ENTERED:
+            command = event.command;
+            break;
+
+        case POSITIONAL: {
+            std::ostringstream oserr;
+            oserr << "ERROR: Unkown argument: " << event.token;
+            result.diagnostics.push_back({event.position, oserr.str()});
+            break;
+        }
+
+        case PARSE_ERROR:
+            result.diagnostics.push_back({event.position, event.error});
+            break;
+
+        case PASSTHROUGH:
+            result.passthroughPosition = event.position;
+            break;
+
+        case OPTION_MATCHED:
+        case VALUE_CONVERTED:
+        case BUILT_IN_MATCHED:
+        case HELP_TERM:
+            break;
+        }
+    }
+    result.path = getCascadeString(command);
+    return result;
+}
+
+/**
+ * @brief Check the arguments given to the constructor, see validate(tokens). Arguments of the passthrough tail are checked for UTF-8 too, like by digest().
+ */
+ValidationResult CmdParserFrame::validate() {
+    ValidationResult result = validate(getArguments());
+    if (_utf8Validation && result.passthroughPosition) {
+        for (int i = int(result.passthroughPosition); i < _argc; ++i) {
+            std::size_t offset = findInvalidUtf8(_argv[i]);
+            if (offset != std::string_view::npos) {
+                std::ostringstream oserr;
+                oserr << "ERROR: Invalid UTF-8 in argument " << i << " at byte " << offset;
+                result.diagnostics.push_back({std::size_t(i), oserr.str()});
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Check the hands of this command and all commands below it for mistakes, which digest() would otherwise silently resolve to the first Option.
+ * In debug builds (without NDEBUG) every constructor checks the command it creates, so each command is checked once.
+ * 
+ * @throws std::invalid_argument if a hand is empty or contains whitespace.
+ * @throws std::invalid_argument if a hand is used by more than one Option, including the built in -h, --help and --license.
+ * @throws std::invalid_argument if a hand equals the name of a SubCommand.
+ */
+void CmdParserFrame::checkHands() {
+    if (_pending) {
+        std::vector<std::string_view> subCommandNames;
+        for (auto& subCommand : _pending->subCommands) subCommandNames.push_back(getCommandName(subCommand));
+        checkHands(_pending->node, subCommandNames);
+        return;
+    }
+    for (auto& node : _nodes) {
+        std::vector<std::string_view> subCommandNames;
+        for (auto subCommand : node.subCommands) subCommandNames.push_back(_nodes[subCommand].commandName);
+        checkHands(node, subCommandNames);
+    }
+}
+
+void CmdParserFrame::checkHands(const CommandNode& node, const std::vector<std::string_view>& subCommandNames) {
+    std::unordered_set<std::string_view> names;
+    for (auto& name : subCommandNames) {
+        if (!names.insert(name).second) {
+            std::ostringstream oserr;
+            oserr << "ERROR: SubCommand >>" << name << "<< is defined twice in: " << node.commandName;
+            throw std::invalid_argument( oserr.str() );
+        }
+    }
+
+    std::unordered_set<std::string> seen;
+    auto check = [&](const std::string& hand) {
+        std::ostringstream oserr;
+        if (isBlankHand(hand)) {
+            oserr << "ERROR: Empty hand or hand with whitespace >>" << hand << "<< in: " << node.commandName;
+        } else if (!seen.insert(hand).second) {
+            oserr << "ERROR: Hand >>" << hand << "<< is used by more than one option in: " << node.commandName;
+        } else if (names.count(hand)) {
+            oserr << "ERROR: Hand >>" << hand << "<< shadows the SubCommand of the same name in: " << node.commandName;
+        } else {
+            return;
+        }
+        throw std::invalid_argument( oserr.str() );
+    };
+    for (auto& builtIn : node.builtIns) {
+        for (auto* hands : {&builtIn.hands, &builtIn.anonymousHands}) {
+            for (auto& hand : *hands) {
+                if (!hand.empty()) check(std::string(hand));
+            }
+        }
+    }
+    for (auto& option : node.options) {
+        for (auto& hand : option.getHands()) check(hand);
+        for (auto& hand : option.getAnonymousHands()) check(hand);
+    }
+}
+
+/**
+ * @brief Check that the help text rendered at compile time of every command is what --help prints without it,
+ * so a CommandSpec cannot silently drift from the Options actually parsed.
+ * Constructors call this in debug builds (without NDEBUG) only.
+ * 
+ * @throws std::invalid_argument naming the first command whose static help differs.
+ */
+void CmdParserFrame::checkStaticHelp() {
+    buildPendingTree();
+    std::size_t active = _activeNode;
+    for (std::size_t node = 0; node < _nodes.size(); ++node) {
+        if (_nodes[node].staticHelp.empty()) continue;
+        _activeNode = node;
+        std::ostringstream runtimeHelp;
+        runtimeHelp << (node == 0 ? _programDescription : _subCommandUsageHeader) << "\n";
+        printAll(SPACES, false, runtimeHelp);
+        _activeNode = active;
+        if (runtimeHelp.str() != _nodes[node].staticHelp) {
+            std::ostringstream oserr;
+            oserr << "ERROR: Static help of >>" << getCascadeString(node) << "<< differs from its Options";
+            throw std::invalid_argument( oserr.str() );
         }
     }
+}
 
-    std::unordered_map<std::string, Option*> opt;
-    for (auto& elem : _options) {
-        for(auto& hand : elem.getHands()) {
-            opt.insert({hand, &elem});
-        }
-        for(auto& hand : elem.getAnonymousHands()) {
-            opt.insert({hand, &elem});
-        }
-    }
-    
+/**
+ * @brief Make digest() check every argument with checkUtf8() before parsing.
+ * 
+ * @param enable Whether to check.
+ */
+void CmdParserFrame::setUtf8Validation(bool enable) {
+    _utf8Validation = enable;
+}
 
-    for (char** itr = _argv + 1; itr != _argv + _argc; ++itr) {
-                auto hand = opt.find(std::string(*itr));
-        if (hand != opt.end()) {
-            if (hand->second->getType() == BOOL) {
-                *(hand->second->pointerBool) = true;
-            } else if (hand->second->getType() == LAMBDA) {
-                hand->second->flagLambda((void*) this);
-            } else {
-                if (itr + 1 != _argv + _argc) {
-                    if (opt.find(*(itr + 1)) == opt.end()) {
-                        switch (hand->second->getType()) 
-                        {
-                        case STRING:
-                            *(hand->second->pointerString) = *(itr + 1);
-                            break;
-
-                        case INT:
-                            try{
-                                *(hand->second->pointerInt) = std::stoi(*(itr + 1));
-                            } catch (...) {
-                                std::ostringstream oserr;
-                                oserr << "ERROR: Expected type >>int<<, but got: " << *(itr + 1);
-                                throw std::invalid_argument( oserr.str() );
-                            }
-                            break;
-                        
-                        case DOUBLE:
-                            try{
-                                *(hand->second->pointerDouble) = std::stod(*(itr + 1));
-                            } catch (...){
-                                std::ostringstream oserr;
-                                oserr << "ERROR: Expected type >>double<<, but got: " << *(itr + 1);
-                                throw std::invalid_argument( oserr.str() );
-                            }
-                            break;
-                        
-                        default:
-                            throw std::invalid_argument( "ERROR: unknown parsing from string to <type>" );
-                            break;
-                        }
-                        ++itr;
-                    }
-                }
-            }
-        } else {
+/**
+ * @brief Check that every argument is valid UTF-8.
+ * 
+ * @throws std::invalid_argument naming the position of the first invalid argument and the offset of the invalid byte.
+ */
+void CmdParserFrame::checkUtf8() {
+    for (int i = 1; i < _argc; ++i) {
+        std::size_t offset = findInvalidUtf8(_argv[i]);
+        if (offset != std::string_view::npos) {
             std::ostringstream oserr;
-            oserr << "ERROR: Unkown argument: " << *(itr);
-            throw std::invalid_argument( oserr.str() ); 
+            oserr << "ERROR: Invalid UTF-8 in argument " << i << " at byte " << offset;
+            throw std::invalid_argument( oserr.str() );
         }
     }
-
 }
 
 /** 
@@ -406,6 +1863,140 @@ void CmdParserFrame::comfortDigest() {
     }
 }
 
+/**
+ * @brief comfortDigest() using cache, see digest(ParseCache&).
+ * 
+ */
+void CmdParserFrame::comfortDigest(ParseCache& cache) {
+    try {
+        digest(cache);
+    } catch(const std::invalid_argument& e) {
+        std::cout << e.what() << std::endl;
+        exit(1);
+    }
+}
+
+/**
+ * @brief Return the three characters at text as key of the trigram index.
+ */
+constexpr std::uint32_t makeTrigram(const char* text) {
+    return std::uint32_t((unsigned char) text[0]) << 16 | std::uint32_t((unsigned char) text[1]) << 8 | std::uint32_t((unsigned char) text[2]);
+}
+
+/**
+ * @brief Return text in lower case. Only ASCII letters are changed.
+ */
+std::string toLowerAscii(std::string_view text) {
+    std::string lower(text);
+    for (auto& c : lower) {
+        if (c >= 'A' && c <= 'Z') c = char(c - 'A' + 'a');
+    }
+    return lower;
+}
+
+/**
+ * @brief Return the index searchHelp() looks terms up in. Built on first use and shared with copies of this parser.
+ */
+const CmdParserFrame::HelpIndex& CmdParserFrame::getHelpIndex() {
+    if (_helpIndex) return *_helpIndex;
+    buildPendingTree();
+
+    auto index = std::make_shared<HelpIndex>();
+    auto addRow = [&](HelpRow row, std::string text) {
+        row.text = toLowerAscii(text);
+        std::uint32_t number = std::uint32_t(index->rows.size());
+        for (std::size_t i = 0; i + 3 <= row.text.size(); ++i) {
+            auto& rows = index->trigrams[makeTrigram(row.text.data() + i)];
+            if (rows.empty() || rows.back() != number) rows.push_back(number);
+        }
+        index->rows.push_back(std::move(row));
+    };
+
+    for (std::size_t command = 0; command < _nodes.size(); ++command) {
+        auto& node = _nodes[command];
+        for (auto& builtIn : node.builtIns) {
+            std::string text;
+            for (auto* hands : {&builtIn.hands, &builtIn.anonymousHands}) {
+                for (auto& hand : *hands) if (!hand.empty()) text.append(hand).append("\n");
+            }
+            text.append(builtIn.description);
+            addRow({command, NO_PARENT, &builtIn}, std::move(text));
+        }
+        for (std::size_t option = 0; option < node.options.size(); ++option) {
+            std::string text;
+            for (auto& hand : node.options[option].getHands()) text.append(hand).append("\n");
+            for (auto& hand : node.options[option].getAnonymousHands()) text.append(hand).append("\n");
+            text.append(node.options[option].getDescription()).append("\n").append(node.options[option].getChoiceList());
+            addRow({command, option}, std::move(text));
+        }
+        for (auto subCommand : node.subCommands) {
+            addRow({command, NO_PARENT, nullptr, subCommand}, _nodes[subCommand].commandName + "\n" + _nodes[subCommand].subCommandDescription);
+        }
+    }
+    _helpIndex = std::move(index);
+    return *_helpIndex;
+}
+
+/**
+ * @brief Search the hands, descriptions and SubCommand names of the active command and all commands below it.
+ * 
+ * The search ignores case of ASCII letters. Terms of three and more characters are looked up in a trigram index, which is built on the first search.
+ * 
+ * @param term The text to search for. An empty term matches every row.
+ * @return std::vector<HelpMatch> The matching rows in the order of the tree.
+ */
+std::vector<HelpMatch> CmdParserFrame::searchHelp(std::string_view term) {
+    const HelpIndex& index = getHelpIndex();
+    std::string needle = toLowerAscii(term);
+
+    std::vector<std::uint32_t> candidates;
+    if (needle.size() < 3) {
+        candidates.resize(index.rows.size());
+        for (std::uint32_t i = 0; i < candidates.size(); ++i) candidates[i] = i;
+    }
+    for (std::size_t i = 0; i + 3 <= needle.size(); ++i) {
+        auto found = index.trigrams.find(makeTrigram(needle.data() + i));
+        if (found == index.trigrams.end()) return {};
+        if (i == 0) {
+            candidates = found->second;
+            continue;
+        }
+        std::vector<std::uint32_t> both;
+        std::set_intersection(candidates.begin(), candidates.end(), found->second.begin(), found->second.end(), std::back_inserter(both));
+        candidates.swap(both);
+        if (candidates.empty()) return {};
+    }
+
+    std::vector<HelpMatch> matches;
+    for (auto number : candidates) {
+        const HelpRow& row = index.rows[number];
+        if (row.text.find(needle) == std::string::npos) continue;
+        std::size_t command = row.command;
+        while (command != NO_PARENT && command != _activeNode) command = _nodes[command].parent;
+        if (command == NO_PARENT) continue;
+
+        HelpMatch match;
+        match.path = getCascadeString(row.command);
+        if (row.builtIn) {
+            for (auto& hand : row.builtIn->hands) if (!hand.empty()) match.hands.emplace_back(hand);
+            match.description = row.builtIn->description;
+        } else if (row.subCommand != NO_PARENT) {
+            match.hands.push_back(_nodes[row.subCommand].commandName);
+            match.description = _nodes[row.subCommand].subCommandDescription;
+            match.isSubCommand = true;
+        } else {
+            const Option& option = _nodes[row.command].options[row.option];
+            match.hands = option.getHands();
+            match.description = option.getDescription();
+            if (option.getType() == CHOICE) {
+                match.description += (match.description.empty() ? "{" : " {") + option.getChoiceList() + "}";
+            }
+        }
+        matches.push_back(std::move(match));
+    }
+    return matches;
+}
+
 
 /**
  * @brief Return n white spaces.
@@ -431,9 +2022,10 @@ std::string space(int n) {
  * @param spaces the amount of spaces between the hands.
  * @return std::string single line string of hands dinstanced by handsAmount spaces.
  */
-std::string makeHandToString(std::vector<std::string> hand, int handsAmount, int spaces) {
+template<typename Hands>
+std::string makeHandToString(const Hands& hand, int handsAmount, int spaces) {
     std::ostringstream os;
-    auto makeRoom = [spaces](std::string& hand) {
+    auto makeRoom = [spaces](std::string_view hand) {
         return space(spaces - int(hand.length()));
     };
     for(auto& elem : hand) {
@@ -448,18 +2040,19 @@ std::string makeHandToString(std::vector<std::string> hand, int handsAmount, int
 /**
  * @brief Return the maximum of count of hands of a single Flag or Option of all Flag or Options.
  * 
- * @param options a list of Options.
+ * @param options a list or vector of Options.
  * @param include lambda or function deciding which Types to inlcude.
  * @return int Example: If the flag Help has the hands "-help", "--help", "-h", "-H" and has the most hands returns 4.
  */
-int getHandCount(std::list<Option> options, std::function<bool(Type)> inlcude = [](Type a){return true;}) {
+template<typename Options>
+int getHandCount(const Options& options, std::function<bool(Type)> inlcude = [](Type a){return true;}) {
     auto max = [](auto a, auto b) {
         if(a > b)
             return a;
         return b;
     };
     int highest = 0;
-    for(auto option : options) {
+    for(auto& option : options) {
         if (!inlcude(option.getType())) continue;        
         int count = 0;
         for(auto& hand : option.getHands()) {
@@ -476,48 +2069,608 @@ int getHandCount(std::list<Option> options, std::function<bool(Type)> inlcude =
  * @param spaces The size of the tabs. Make larger for long options.
  * @param prefix First line of print gets a prefix.
  * @param include The data Type of Option you want to include, like BOOL for flags.
+ * @param out The stream to print to.
  */
-void CmdParserFrame::printOptions(int spaces, std::string prefix, std::function<bool(Type)> include) {
-    int amountOfFlags = getHandCount(_options, include );
+void CmdParserFrame::printOptions(int spaces, std::string prefix, std::function<bool(Type)> include, std::ostream& out) {
+    buildPendingTree();
+    int amountOfFlags = getHandCount(_nodes[_activeNode].options, include );
     bool firstLine = true;
-    for(auto& opt : _options) {
+    for(auto& builtIn : _nodes[_activeNode].builtIns) {
+        if (include(builtIn.type)) {
+            amountOfFlags = std::max(amountOfFlags, builtIn.handCount());
+        }
+    }
+    for(auto& builtIn : _nodes[_activeNode].builtIns) {
+        if (include(builtIn.type)) {
+            out << (firstLine ? prefix + space(spaces - int(prefix.length())) : space(spaces));
+            firstLine = false;
+            out << makeHandToString(std::span(builtIn.hands.data(), builtIn.handCount()), amountOfFlags, spaces) << builtIn.description << std::endl;
+        }
+    }
+    for(auto& opt : _nodes[_activeNode].options) {
         if (include(opt.getType())) {
             if (firstLine) {
                 firstLine = false;
-                std::cout << prefix << space(spaces - int(prefix.length()));
+                out << prefix << space(spaces - int(prefix.length()));
             } else {
-                std::cout << space(spaces);
+                out << space(spaces);
+            }
+            out << makeHandToString(opt.getHands(), amountOfFlags, spaces) << opt.getDescription();
+            if (opt.getType() == CHOICE) {
+                out << (opt.getDescription().empty() ? "" : " ") << "{" << opt.getChoiceList() << "}";
             }
-            std::cout << makeHandToString(opt.getHands(), amountOfFlags, spaces) << opt.getDescription() << std::endl;
+            out << std::endl;
         }
     }
 }
 
 
+/**
+ * @brief Pretty print the rows found by searchHelp(), each after the command it belongs to. Used by --help <term>.
+ * 
+ * @param term The text to search for.
+ * @param spaces the amount of spaces between hands.
+ */
+void CmdParserFrame::printSearch(std::string_view term, int spaces) {
+    std::vector<HelpMatch> matches = searchHelp(term);
+    if (matches.empty()) {
+        std::cout << "\nNo matches for: " << term << "\n" << std::endl;
+        return;
+    }
+
+    int pathLength = 0;
+    int handCount = 0;
+    for (auto& match : matches) {
+        pathLength = std::max(pathLength, int(match.path.length()));
+        handCount = std::max(handCount, int(match.hands.size()));
+    }
+    int pathColumn = (pathLength / spaces + 1) * spaces;
+
+    std::cout << "\nMatches for: " << term << "\n" << std::endl;
+    for (auto& match : matches) {
+        std::cout << match.path << space(pathColumn - int(match.path.length())) << makeHandToString(match.hands, handCount, spaces) << match.description << std::endl;
+    }
+    std::cout << std::endl;
+}
+
+
 /**
  * @brief Pretty print all hands of all flags and options and description of said structs.
  * 
  * @param spaces the amount of spaces between hands.
+ * @param andExit Exit the program after printing.
+ * @param out The stream to print to.
  */
-void CmdParserFrame::printAll(int spaces, bool andExit) {
-    std::cout << "\nUsage for: " << _subCommandCascadeString << "\n" << std::endl;
-
-    printOptions(spaces, "Flags:", [](Type a){return a == BOOL || a == LAMBDA;});
-    std::cout << " " << std::endl;
-    printOptions(spaces, "Options:", [](Type a){return a != BOOL && a != LAMBDA;});
-           
-    for (int i = 0; i < _subCommands.size(); ++i) {
-        if (i == 0) std::cout << "\nSubcmd:" << space(spaces - 7);
-        else std::cout << space(spaces);
-        std::cout << _subCommands[i]._commandName << space(spaces*2 - int(_subCommands[i]._commandName.length())) << _subCommands[i]._subCommandDescription << std::endl;
-    }
-    if (_subCommands.size() == 1)
-        std::cout << "\nFor more help: " << _subCommandCascadeString << " " << _subCommands[0]._commandName << " --help\n" << std::endl;
-    if (_subCommands.size() > 1)
-        std::cout << "\nFor more help: " << _subCommandCascadeString << " [subcmd] --help\n" << std::endl;
+void CmdParserFrame::printAll(int spaces, bool andExit, std::ostream& out) {
+    buildPendingTree();
+    std::string cascadeString = getCascadeString(_activeNode);
+    out << "\nUsage for: " << cascadeString << "\n" << std::endl;
+
+    printOptions(spaces, "Flags:", [](Type a){return a == BOOL || a == LAMBDA;}, out);
+    out << " " << std::endl;
+    printOptions(spaces, "Options:", [](Type a){return a != BOOL && a != LAMBDA;}, out);
+
+    auto& subCommands = _nodes[_activeNode].subCommands;
+    for (std::size_t i = 0; i < subCommands.size(); ++i) {
+        auto& subCommand = _nodes[subCommands[i]];
+        if (i == 0) out << "\nSubcmd:" << space(spaces - 7);
+        else out << space(spaces);
+        out << subCommand.commandName << space(spaces*2 - int(subCommand.commandName.length())) << subCommand.subCommandDescription << std::endl;
+    }
+    if (subCommands.size() == 1)
+        out << "\nFor more help: " << cascadeString << " " << _nodes[subCommands[0]].commandName << " --help\n" << std::endl;
+    if (subCommands.size() > 1)
+        out << "\nFor more help: " << cascadeString << " [subcmd] --help\n" << std::endl;
     
     if (andExit) exit(0);
 }
 
 
+/* ============================================================================================================================== */
+
+/// @brief Compile time description of a SubCommand as listed in the usage of its parent.
+struct SubCommandSpec {
+    std::string_view name;
+    std::string_view description = "";
+};
+
+/**
+ * Compile time description of a command, mirroring what a CmdParser or SubCommand prints for --help.
+ * 
+ * @param name Name shown after "Usage for:". For SubCommands the whole path, like "program sub".
+ * @param description Printed above the usage by renderHelp(). programDescription of a CmdParser, subCommandUsageHeader of a SubCommand.
+ * @param options The Options in the order they are printed. Add HELP_OPTION and LICENSE_OPTION to match the built in ones.
+ * @param subCommands The SubCommands of this command.
+ */
+template<std::size_t NOptions, std::size_t NSubCommands = 0>
+struct CommandSpec {
+    std::string_view name;
+    std::string_view description;
+    std::array<OptionSpec, NOptions> options;
+    std::array<SubCommandSpec, NSubCommands> subCommands = {};
+};
+
+/**
+ * @brief Check if an OptionSpec has a hand which is empty or contains whitespace. Empty entries are only allowed after the last hand.
+ */
+constexpr bool hasBlankHand(const OptionSpec& option) {
+    for (auto* hands : {&option.hands, &option.anonymousHands}) {
+        bool ended = false;
+        for (auto& hand : *hands) {
+            if (hand.empty()) ended = true;
+            else if (ended || isBlankHand(hand)) return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Check if any OptionSpec of a CommandSpec has a hand which is empty or contains whitespace.
+ */
+template<std::size_t NOptions, std::size_t NSubCommands>
+constexpr bool hasBlankHand(const CommandSpec<NOptions, NSubCommands>& spec) {
+    for (auto& option : spec.options) {
+        if (hasBlankHand(option)) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Call f for every hand, shown or anonymous, of every OptionSpec of a CommandSpec. Stops as soon as f returns true.
+ * 
+ * @return true if f returned true.
+ */
+template<std::size_t NOptions, std::size_t NSubCommands, typename F>
+constexpr bool anyHand(const CommandSpec<NOptions, NSubCommands>& spec, F f) {
+    for (auto& option : spec.options) {
+        for (auto* hands : {&option.hands, &option.anonymousHands}) {
+            for (auto& hand : *hands) {
+                if (!hand.empty() && f(hand)) return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Check if two hands of a CommandSpec are the same, within one OptionSpec or across OptionSpecs.
+ */
+template<std::size_t NOptions, std::size_t NSubCommands>
+constexpr bool hasDuplicateHand(const CommandSpec<NOptions, NSubCommands>& spec) {
+    return anyHand(spec, [&](const std::string_view& hand) {
+        return anyHand(spec, [&](const std::string_view& other) {
+            return &hand != &other && hand == other;
+        });
+    });
+}
+
+/**
+ * @brief Check if a hand of a CommandSpec equals the name of one of its SubCommands.
+ */
+template<std::size_t NOptions, std::size_t NSubCommands>
+constexpr bool hasHandShadowingSubCommand(const CommandSpec<NOptions, NSubCommands>& spec) {
+    return anyHand(spec, [&](const std::string_view& hand) {
+        for (auto& subCommand : spec.subCommands) {
+            if (subCommand.name == hand) return true;
+        }
+        return false;
+    });
+}
+
+/**
+ * @brief Check if two SubCommands of a CommandSpec have the same name.
+ */
+template<std::size_t NOptions, std::size_t NSubCommands>
+constexpr bool hasDuplicateSubCommand(const CommandSpec<NOptions, NSubCommands>& spec) {
+    for (std::size_t i = 0; i < NSubCommands; ++i) {
+        for (std::size_t j = i + 1; j < NSubCommands; ++j) {
+            if (spec.subCommands[i].name == spec.subCommands[j].name) return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Reject mistakes in a CommandSpec at compile time. Called by renderUsage() and renderHelp().
+ * 
+ * static_assert(checkSpec<spec>());
+ * 
+ * @tparam Spec A constexpr CommandSpec with static storage duration.
+ */
+template<const auto& Spec>
+constexpr bool checkSpec() {
+    static_assert(!hasBlankHand(Spec), "libcmd: CommandSpec has an empty hand or a hand containing whitespace");
+    static_assert(!hasDuplicateHand(Spec), "libcmd: CommandSpec uses the same hand for more than one option (is -h or --license both yours and built in?)");
+    static_assert(!hasHandShadowingSubCommand(Spec), "libcmd: CommandSpec has a hand with the same name as one of its SubCommands");
+    static_assert(!hasDuplicateSubCommand(Spec), "libcmd: CommandSpec has two SubCommands with the same name");
+    return true;
+}
+
+
+/**
+ * Writes text into a buffer at compile time. Without a buffer it only counts the characters, which is used to size the buffer.
+ */
+class StaticWriter {
+private:
+    char* _out;
+    std::size_t _size = 0;
+
+public:
+    constexpr explicit StaticWriter(char* out) : _out(out) {}
+
+    constexpr void write(std::string_view text) {
+        for (char c : text) {
+            if (_out) _out[_size] = c;
+            ++_size;
+        }
+    }
+
+    constexpr void space(int n) {
+        for (int i = 0; i < n; ++i) write(" ");
+    }
+
+    constexpr std::size_t size() const {
+        return _size;
+    }
+};
+
+/// @brief Text rendered at compile time, usable as std::string_view.
+template<std::size_t N>
+struct StaticText {
+    std::array<char, N> data;
+
+    constexpr std::string_view view() const {
+        return {data.data(), N};
+    }
+
+    constexpr operator std::string_view() const {
+        return view();
+    }
+};
+
+/**
+ * @brief Compile time version of CmdParserFrame::printOptions().
+ */
+template<typename Writer, std::size_t NOptions>
+constexpr void writeOptions(Writer& out, const std::array<OptionSpec, NOptions>& options, int spaces, std::string_view prefix, bool flags) {
+    auto include = [flags](Type type) { return (type == BOOL || type == LAMBDA) == flags; };
+
+    int amountOfFlags = 0;
+    for (auto& opt : options) {
+        if (include(opt.type) && opt.handCount() > amountOfFlags) amountOfFlags = opt.handCount();
+    }
+
+    bool firstLine = true;
+    for (auto& opt : options) {
+        if (!include(opt.type)) continue;
+        if (firstLine) {
+            firstLine = false;
+            out.write(prefix);
+            out.space(spaces - int(prefix.length()));
+        } else {
+            out.space(spaces);
+        }
+        for (auto& hand : opt.hands) {
+            if (hand.empty()) continue;
+            out.write(hand);
+            out.space(spaces - int(hand.length()));
+        }
+        for (int i = 0; i < amountOfFlags - opt.handCount(); ++i) out.space(spaces);
+        out.write(opt.description);
+        if (opt.type == CHOICE) {
+            out.write(opt.description.empty() ? "{" : " {");
+            out.write(opt.choices);
+            out.write("}");
+        }
+        out.write("\n");
+    }
+}
+
+/**
+ * @brief Compile time version of CmdParserFrame::printAll().
+ */
+template<typename Writer, std::size_t NOptions, std::size_t NSubCommands>
+constexpr void writeUsage(Writer& out, const CommandSpec<NOptions, NSubCommands>& spec, int spaces) {
+    out.write("\nUsage for: ");
+    out.write(spec.name);
+    out.write("\n\n");
+
+    writeOptions(out, spec.options, spaces, "Flags:", true);
+    out.write(" \n");
+    writeOptions(out, spec.options, spaces, "Options:", false);
+
+    for (std::size_t i = 0; i < NSubCommands; ++i) {
+        if (i == 0) {
+            out.write("\nSubcmd:");
+            out.space(spaces - 7);
+        } else {
+            out.space(spaces);
+        }
+        out.write(spec.subCommands[i].name);
+        out.space(spaces*2 - int(spec.subCommands[i].name.length()));
+        out.write(spec.subCommands[i].description);
+        out.write("\n");
+    }
+    if (NSubCommands >= 1) {
+        out.write("\nFor more help: ");
+        out.write(spec.name);
+        out.write(" ");
+        out.write(NSubCommands == 1 ? spec.subCommands[0].name : "[subcmd]");
+        out.write(" --help\n\n");
+    }
+}
+
+/**
+ * @brief Compile time version of what the --help flag prints: The description followed by the usage.
+ */
+template<typename Writer, std::size_t NOptions, std::size_t NSubCommands>
+constexpr void writeHelp(Writer& out, const CommandSpec<NOptions, NSubCommands>& spec, int spaces) {
+    out.write(spec.description);
+    out.write("\n");
+    writeUsage(out, spec, spaces);
+}
+
+/**
+ * @brief Render the usage of a CommandSpec at compile time. Same text as printAll().
+ * 
+ * static constexpr auto usage = renderUsage<spec>();
+ * 
+ * @tparam Spec A constexpr CommandSpec with static storage duration.
+ * @tparam Spaces The size of the tabs, as in printAll().
+ */
+template<const auto& Spec, int Spaces = SPACES>
+constexpr auto renderUsage() {
+    static_assert(checkSpec<Spec>());
+    constexpr std::size_t size = [] {
+        StaticWriter counter(nullptr);
+        writeUsage(counter, Spec, Spaces);
+        return counter.size();
+    }();
+    StaticText<size> text {};
+    StaticWriter writer(text.data.data());
+    writeUsage(writer, Spec, Spaces);
+    return text;
+}
+
+/**
+ * @brief Render the --help text of a CommandSpec at compile time. Pass it as staticHelp to CmdParser or SubCommand.
+ * 
+ * static constexpr auto help = renderHelp<spec>();
+ * 
+ * @tparam Spec A constexpr CommandSpec with static storage duration.
+ * @tparam Spaces The size of the tabs, as in printAll().
+ */
+template<const auto& Spec, int Spaces = SPACES>
+constexpr auto renderHelp() {
+    static_assert(checkSpec<Spec>());
+    constexpr std::size_t size = [] {
+        StaticWriter counter(nullptr);
+        writeHelp(counter, Spec, Spaces);
+        return counter.size();
+    }();
+    StaticText<size> text {};
+    StaticWriter writer(text.data.data());
+    writeHelp(writer, Spec, Spaces);
+    return text;
+}
+
+
+/* ============================================================================================================================== */
+
+/**
+ * @brief Return the name of a Type as used in the schema export, like "int" for INT.
+ */
+constexpr std::string_view getTypeName(Type type) {
+    switch (type) {
+    case BOOL: return "bool";
+    case STRING: return "string";
+    case INT: return "int";
+    case DOUBLE: return "double";
+    case LAMBDA: return "lambda";
+    case CHOICE: return "choice";
+    case DURATION: return "duration";
+    case BYTES: return "bytes";
+    }
+    return "";
+}
+
+/**
+ * @brief Write text as JSON string, with quotes.
+ */
+template<typename Writer>
+constexpr void writeJsonString(Writer& out, std::string_view text) {
+    constexpr std::string_view digits = "0123456789abcdef";
+    out.write("\"");
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = (unsigned char) text[i];
+        if (c == '"') out.write("\\\"");
+        else if (c == '\\') out.write("\\\\");
+        else if (c == '\n') out.write("\\n");
+        else if (c == '\t') out.write("\\t");
+        else if (c < 0x20) {
+            out.write("\\u00");
+            out.write(digits.substr(c >> 4, 1));
+            out.write(digits.substr(c & 0xf, 1));
+        }
+        else out.write(text.substr(i, 1));
+    }
+    out.write("\"");
+}
+
+/**
+ * @brief Write the non empty hands as JSON array of strings.
+ */
+template<typename Writer, typename Hands>
+constexpr void writeJsonHands(Writer& out, const Hands& hands) {
+    out.write("[");
+    bool first = true;
+    for (auto& hand : hands) {
+        if (hand.empty()) continue;
+        if (!first) out.write(",");
+        first = false;
+        writeJsonString(out, hand);
+    }
+    out.write("]");
+}
+
+/**
+ * @brief Write the accepted strings of a CHOICE OptionSpec, separated by "|" in choices, as JSON array of strings.
+ */
+template<typename Writer>
+constexpr void writeJsonChoices(Writer& out, std::string_view choices) {
+    if (choices.empty()) {
+        out.write("[]");
+        return;
+    }
+    out.write("[");
+    for (std::size_t begin = 0; begin <= choices.size(); ) {
+        std::size_t end = choices.find('|', begin);
+        if (end == std::string_view::npos) end = choices.size();
+        if (begin != 0) out.write(",");
+        writeJsonString(out, choices.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    out.write("]");
+}
+
+/**
+ * @brief Write the accepted strings of a CHOICE Option as JSON array of strings, straight from its choice table.
+ */
+template<typename Writer>
+void writeJsonChoices(Writer& out, const Option& option) {
+    out.write("[");
+    for (std::size_t i = 0; i < option.getChoiceCount(); ++i) {
+        if (i) out.write(",");
+        writeJsonString(out, option.getChoice(i));
+    }
+    out.write("]");
+}
+
+/**
+ * @brief Write an Option as JSON object. choices is what writeJsonChoices() takes: the "|" separated choices of an OptionSpec or the Option itself.
+ */
+template<typename Writer, typename Hands, typename AnonymousHands, typename Choices>
+constexpr void writeJsonOption(Writer& out, Type type, const Hands& hands, const AnonymousHands& anonymousHands, std::string_view description, const Choices& choices) {
+    out.write("{\"type\":");
+    writeJsonString(out, getTypeName(type));
+    out.write(",\"hands\":");
+    writeJsonHands(out, hands);
+    out.write(",\"anonymousHands\":");
+    writeJsonHands(out, anonymousHands);
+    out.write(",\"description\":");
+    writeJsonString(out, description);
+    if (type == CHOICE) {
+        out.write(",\"choices\":");
+        writeJsonChoices(out, choices);
+    }
+    out.write("}");
+}
+
+/**
+ * @brief Write a CommandSpec as JSON object. The fields of an Option are the same as for CmdParserFrame::exportSchema(),
+ * but the command is shallow, see renderSchema().
+ */
+template<typename Writer, std::size_t NOptions, std::size_t NSubCommands>
+constexpr void writeSchema(Writer& out, const CommandSpec<NOptions, NSubCommands>& spec) {
+    out.write("{\"name\":");
+    writeJsonString(out, spec.name);
+    out.write(",\"description\":");
+    writeJsonString(out, spec.description);
+    out.write(",\"options\":[");
+    for (std::size_t i = 0; i < NOptions; ++i) {
+        if (i) out.write(",");
+        auto& option = spec.options[i];
+        writeJsonOption(out, option.type, option.hands, option.anonymousHands, option.description, option.choices);
+    }
+    out.write("],\"subCommands\":[");
+    for (std::size_t i = 0; i < NSubCommands; ++i) {
+        if (i) out.write(",");
+        out.write("{\"name\":");
+        writeJsonString(out, spec.subCommands[i].name);
+        out.write(",\"description\":");
+        writeJsonString(out, spec.subCommands[i].description);
+        out.write("}");
+    }
+    out.write("]}");
+}
+
+/**
+ * @brief Render the schema of a CommandSpec as JSON at compile time.
+ * 
+ * A CommandSpec describes the help of one command, so this is a shallow format distinct from CmdParserFrame::exportSchema():
+ * name and description are taken from the CommandSpec as they are, for a SubCommand the whole path and its usage header,
+ * and SubCommands have only "name" and "description", no "options" or "subCommands". Options are written like exportSchema() does.
+ * 
+ * static constexpr auto schema = renderSchema<spec>();
+ * 
+ * @tparam Spec A constexpr CommandSpec with static storage duration.
+ */
+template<const auto& Spec>
+constexpr auto renderSchema() {
+    static_assert(checkSpec<Spec>());
+    constexpr std::size_t size = [] {
+        StaticWriter counter(nullptr);
+        writeSchema(counter, Spec);
+        return counter.size();
+    }();
+    StaticText<size> text {};
+    StaticWriter writer(text.data.data());
+    writeSchema(writer, Spec);
+    return text;
+}
+
+/**
+ * @brief Write node and all commands below it as JSON object.
+ */
+template<typename Writer>
+void CmdParserFrame::writeSchema(Writer& out, std::size_t node) {
+    auto& command = _nodes[node];
+    out.write("{\"name\":");
+    writeJsonString(out, command.commandName);
+    out.write(",\"description\":");
+    writeJsonString(out, node == 0 && !_pending ? _programDescription : command.subCommandDescription);
+    if (command.passthroughTail) out.write(",\"passthrough\":true");
+    out.write(",\"options\":[");
+    bool first = true;
+    for (auto& builtIn : command.builtIns) {
+        if (!first) out.write(",");
+        first = false;
+        writeJsonOption(out, builtIn.type, builtIn.hands, builtIn.anonymousHands, builtIn.description, builtIn.choices);
+    }
+    for (auto& option : command.options) {
+        if (!first) out.write(",");
+        first = false;
+        writeJsonOption(out, option.getType(), option.getHands(), option.getAnonymousHands(), option.getDescription(), option);
+    }
+    out.write("],\"subCommands\":[");
+    for (std::size_t i = 0; i < command.subCommands.size(); ++i) {
+        if (i) out.write(",");
+        writeSchema(out, command.subCommands[i]);
+    }
+    out.write("]}");
+}
+
+/**
+ * @brief Export the Options and SubCommands of the whole tree as JSON. Created on first use and shared with copies of this parser.
+ * 
+ * {"name":"program","description":"...","options":[{"type":"int","hands":["-n","--number"],"anonymousHands":[],"description":"input integer"}],"subCommands":[...]}
+ * 
+ * Types are named like Type in lower case. CHOICE Options list their "choices", SubCommands with a passthrough tail have "passthrough":true.
+ * 
+ * @return std::string_view The JSON text, valid as long as this parser.
+ */
+std::string_view CmdParserFrame::exportSchema() {
+    if (!_schema) {
+        buildPendingTree();
+        StaticWriter counter(nullptr);
+        writeSchema(counter, 0);
+        auto schema = std::make_shared<std::string>(counter.size(), '\0');
+        StaticWriter writer(schema->data());
+        writeSchema(writer, 0);
+        _schema = std::move(schema);
+    }
+    return *_schema;
+}
+
+
 #endif
\ No newline at end of file
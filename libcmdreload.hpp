@@ -0,0 +1,323 @@
+
+/*
+ * Copyright (c) 2021, 2023 Adam McKellar
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+#ifndef LIB_CMD_RELOAD
+#define LIB_CMD_RELOAD
+
+#include "libcmd.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <fstream>
+
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/inotify.h>
+
+/* ============================================================================================================================== */
+
+/**
+ * Class for reloading Options from a config file while the program runs (Linux only).
+ *
+ * The values live in a Config struct. schema binds the Options to a given Config, the same way you bind them to variables for CmdParser.
+ * Every reload parses the file into a copy of the initial Config and publishes that copy as new immutable snapshot,
+ * so removing a line from the file resets its Option to the initial value.
+ * Readers get the current snapshot with current(), which is lock free: two atomic operations to pin the snapshot and one to release it.
+ * Only Options marked with setReloadable() are changed, values of other Options in the file are ignored, even if they are invalid.
+ *
+ * Old snapshots are freed after a grace period: reload() publishes the new snapshot and then waits until every Snapshot pinned
+ * before that is released. So keep a Snapshot only as long as you use it, never across a call of reload() on the same thread,
+ * and release all of them before the ConfigReloader is destroyed.
+ *
+ * The config file holds one option per line, the hand followed by its value. Empty lines and lines starting with # are skipped:
+ *
+ * # comment
+ * --timeout 5s
+ * --verbose
+ */
+template<typename Config>
+class ConfigReloader {
+public:
+    /// @brief A pinned snapshot returned by current(). Not freed by reload() until it is released.
+    class Snapshot {
+    public:
+        Snapshot(Snapshot&& other) noexcept : _config(other._config), _readers(other._readers) { other._readers = nullptr; }
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        Snapshot& operator=(Snapshot&&) = delete;
+        ~Snapshot() { if (_readers) _readers->fetch_sub(1, std::memory_order_release); }
+
+        const Config& operator*() const noexcept { return *_config; }
+        const Config* operator->() const noexcept { return _config; }
+        const Config* get() const noexcept { return _config; }
+
+    private:
+        friend class ConfigReloader;
+        Snapshot(const Config* config, std::atomic<std::size_t>* readers) : _config(config), _readers(readers) {}
+
+        const Config* _config;
+        std::atomic<std::size_t>* _readers;
+    };
+
+private:
+    std::string _path;
+    std::function<std::list<Option>(Config&)> _schema;
+    std::function<void(const std::string&)> _onError;
+    const Config _initial;
+
+    std::atomic<const Config*> _current;
+    mutable std::atomic<std::size_t> _epoch {0};
+    mutable std::atomic<std::size_t> _readers[2] {};
+    std::mutex _reloadMutex;
+
+    std::thread _watcher;
+    int _stopPipe[2] = {-1, -1};
+
+    std::vector<std::string> readTokens();
+    void watchLoop(int inotifyFd);
+    void waitForReaders();
+
+public:
+    ConfigReloader(std::string path,
+        Config initial,
+        std::function<std::list<Option>(Config&)> schema,
+        std::function<void(const std::string&)> onError = {}
+        );
+    ~ConfigReloader();
+
+    ConfigReloader(const ConfigReloader&) = delete;
+    ConfigReloader& operator=(const ConfigReloader&) = delete;
+
+    Snapshot current() const noexcept;
+    bool reload();
+    void watch();
+    void stop();
+};
+
+
+/**
+ * @brief Construct a new ConfigReloader. The file is neither read nor watched yet, call reload() and watch() for that.
+ *
+ * @param path Path of the config file.
+ * @param initial First snapshot, usually the values parsed from argv. Every reload starts from it.
+ * @param schema Returns the Options bound to the members of the given Config.
+ * @param onError Called with the error message if a reload fails. The old snapshot stays current.
+ */
+template<typename Config>
+ConfigReloader<Config>::ConfigReloader(std::string path,
+                    Config initial,
+                    std::function<std::list<Option>(Config&)> schema,
+                    std::function<void(const std::string&)> onError
+                    )
+    : _path(path), _schema(schema), _onError(onError), _initial(std::move(initial)), _current(new Config(_initial))
+{
+}
+
+template<typename Config>
+ConfigReloader<Config>::~ConfigReloader() {
+    stop();
+    delete _current.load();
+}
+
+/**
+ * @brief Pin and return the current snapshot. Lock free, safe to call from any thread.
+ */
+template<typename Config>
+typename ConfigReloader<Config>::Snapshot ConfigReloader<Config>::current() const noexcept {
+    std::atomic<std::size_t>* readers = &_readers[_epoch.load()];
+    readers->fetch_add(1);
+    return Snapshot(_current.load(), readers);
+}
+
+/**
+ * @brief Wait until every Snapshot pinned before the last snapshot was published is released.
+ *
+ * Such a Snapshot is counted under either epoch. Flipping the epoch before waiting for the old one lets new readers count
+ * under the other epoch, so a steady stream of readers cannot keep a count from draining.
+ */
+template<typename Config>
+void ConfigReloader<Config>::waitForReaders() {
+    for (int i = 0; i < 2; ++i) {
+        std::size_t epoch = _epoch.load();
+        _epoch.store(epoch ^ 1);
+        while (_readers[epoch].load() != 0) std::this_thread::yield();
+    }
+}
+
+/**
+ * @brief Split the config file into argv like tokens.
+ *
+ * @throws std::invalid_argument if the file cannot be opened.
+ */
+template<typename Config>
+std::vector<std::string> ConfigReloader<Config>::readTokens() {
+    std::ifstream file(_path);
+    if (!file) {
+        std::ostringstream oserr;
+        oserr << "ERROR: Could not open config file: " << _path;
+        throw std::invalid_argument( oserr.str() );
+    }
+
+    std::vector<std::string> tokens;
+    std::string line;
+    while (std::getline(file, line)) {
+        auto isSpace = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+        auto begin = std::find_if_not(line.begin(), line.end(), isSpace);
+        auto end = std::find_if_not(line.rbegin(), line.rend(), isSpace).base();
+        if (begin >= end || *begin == '#') continue;
+
+        auto handEnd = std::find_if(begin, end, isSpace);
+        tokens.emplace_back(begin, handEnd);
+        auto valueBegin = std::find_if_not(handEnd, end, isSpace);
+        if (valueBegin != end) tokens.emplace_back(valueBegin, end);
+    }
+    return tokens;
+}
+
+/**
+ * @brief Parse the config file and publish the result as new snapshot.
+ *
+ * Waits until every Snapshot of the old snapshot is released, so do not hold one on the calling thread.
+ *
+ * @return true if the file was parsed and a new snapshot published.
+ */
+template<typename Config>
+bool ConfigReloader<Config>::reload() {
+    std::lock_guard<std::mutex> lock(_reloadMutex);
+
+    auto next = std::make_unique<Config>(_initial);
+    try {
+        std::vector<std::string> tokens = readTokens();
+        std::vector<char*> argv;
+        argv.push_back(_path.data());
+        for (auto& token : tokens) argv.push_back(token.data());
+        argv.push_back(nullptr);
+
+        CmdParserFrame pars(int(argv.size()) - 1, argv.data(), _schema(*next));
+        for (auto& event : pars.events()) {
+            // Values of Options which are not reloadable are skipped, even if they could not be converted.
+            if (event.option && !event.option->isReloadable()) continue;
+
+            switch (event.kind) {
+            case OPTION_MATCHED:
+                if (event.option->getType() == BOOL || event.option->getType() == LAMBDA) event.option->applyValue(std::monostate(), (void*) &pars);
+                break;
+
+            case VALUE_CONVERTED:
+                event.option->applyValue(event.value, (void*) &pars);
+                break;
+
+            case POSITIONAL: {
+                std::ostringstream oserr;
+                oserr << "ERROR: Unkown argument: " << event.token;
+                throw std::invalid_argument( oserr.str() );
+            }
+
+            case PARSE_ERROR:
+                throw std::invalid_argument( event.error );
+
+            case SUBCOMMAND_ENTERED:
+            case BUILT_IN_MATCHED:
+            case PASSTHROUGH:
+            case HELP_TERM:
+                break;
+            }
+        }
+    } catch (const std::invalid_argument& e) {
+        if (_onError) _onError(e.what());
+        return false;
+    }
+
+    const Config* old = _current.exchange(next.release());
+    waitForReaders();
+    delete old;
+    return true;
+}
+
+/**
+ * @brief Start a thread which reloads the config file every time it is written or replaced.
+ *
+ * @throws std::runtime_error if inotify is not available.
+ */
+template<typename Config>
+void ConfigReloader<Config>::watch() {
+    if (_watcher.joinable()) return;
+
+    // Editors usually replace the file, so the directory is watched instead of the file itself.
+    // Only finished writes and renames count, a newly created file may still be empty.
+    std::size_t slash = _path.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : _path.substr(0, slash));
+
+    int inotifyFd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (inotifyFd < 0) throw std::runtime_error( "ERROR: inotify_init1 failed" );
+    if (inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(inotifyFd);
+        throw std::runtime_error( "ERROR: could not watch directory: " + directory );
+    }
+    if (pipe2(_stopPipe, O_CLOEXEC) != 0) {
+        close(inotifyFd);
+        throw std::runtime_error( "ERROR: pipe2 failed" );
+    }
+
+    _watcher = std::thread([this, inotifyFd] { watchLoop(inotifyFd); });
+}
+
+template<typename Config>
+void ConfigReloader<Config>::watchLoop(int inotifyFd) {
+    std::size_t slash = _path.rfind('/');
+    std::string fileName = slash == std::string::npos ? _path : _path.substr(slash + 1);
+
+    alignas(inotify_event) char buffer[4096];
+    pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {_stopPipe[0], POLLIN, 0}};
+    while (true) {
+        if (poll(fds, 2, -1) < 0) continue;
+        if (fds[1].revents) break;
+
+        bool changed = false;
+        ssize_t length;
+        while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+            for (char* ptr = buffer; ptr < buffer + length; ) {
+                auto* event = reinterpret_cast<inotify_event*>(ptr);
+                if (event->len && fileName == event->name) changed = true;
+                ptr += sizeof(inotify_event) + event->len;
+            }
+        }
+        if (changed) reload();
+    }
+    close(inotifyFd);
+}
+
+/**
+ * @brief Stop the thread started by watch(). Called by the destructor.
+ */
+template<typename Config>
+void ConfigReloader<Config>::stop() {
+    if (!_watcher.joinable()) return;
+    char wake = 0;
+    (void) !write(_stopPipe[1], &wake, 1);
+    _watcher.join();
+    close(_stopPipe[0]);
+    close(_stopPipe[1]);
+    _stopPipe[0] = _stopPipe[1] = -1;
+}
+
+
+#endif
@@ -17,8 +17,13 @@
 
 
 #include <catch2/catch_test_macros.hpp>
+#include <ranges>
 #include "../libcmd.hpp"
 
+#ifdef __linux__
+#include "../libcmdreload.hpp"
+#endif
+
 
 TEST_CASE( "parseEmptyNoFlagsAndOptions", "[empty]" ) {
     auto executor = [](int argc, char** argv) {
@@ -378,3 +383,1055 @@ TEST_CASE( "parseSubcommands", "parsesubcommands" ) {
         REQUIRE(inputStr == "wasd");
     }
 }
+
+
+enum class Mode {FAST, SAFE, REPLAY};
+
+static constexpr Choices<Mode, 3> modes {{"fast", "safe", "replay"}, {Mode::FAST, Mode::SAFE, Mode::REPLAY}};
+
+// Tables are only taken as template argument, so they cannot dangle.
+static_assert(!std::is_constructible_v<Option, Mode*, const Choices<Mode, 3>&, std::vector<std::string>>);
+static_assert(std::is_constructible_v<Option, Mode*, ChoiceTable<modes>, std::vector<std::string>>);
+
+TEST_CASE( "parseChoiceOptions", "[choices]" ) {
+    SECTION( "valid choice" ) {
+        Mode mode = Mode::FAST;
+
+        const char* argv[] = {"programm", "--mode", "replay", nullptr};
+
+        CmdParserFrame pars {
+            3,
+            const_cast<char**>(argv),
+            {
+                Option(&mode, choicesOf<modes>, {"-m", "--mode"}, "execution mode")
+            }
+        };
+        pars.digest();
+
+        REQUIRE(mode == Mode::REPLAY);
+    }
+
+    SECTION( "invalid choice" ) {
+        Mode mode = Mode::FAST;
+
+        const char* argv[] = {"programm", "--mode", "slow", nullptr};
+
+        CmdParserFrame pars {
+            3,
+            const_cast<char**>(argv),
+            {
+                Option(&mode, choicesOf<modes>, {"-m", "--mode"}, "execution mode")
+            }
+        };
+
+        REQUIRE_THROWS_WITH(pars.digest(), "ERROR: Expected one of >>fast|safe|replay<<, but got: slow");
+        REQUIRE(mode == Mode::FAST);
+    }
+}
+
+
+TEST_CASE( "parseDurationAndByteSize", "[units]" ) {
+    using namespace std::chrono_literals;
+
+    SECTION( "durations" ) {
+        std::chrono::nanoseconds duration {};
+
+        REQUIRE(parseDuration("250ms", duration));
+        REQUIRE(duration == 250ms);
+        REQUIRE(parseDuration("1h30m", duration));
+        REQUIRE(duration == 90min);
+        REQUIRE(parseDuration("1.5s", duration));
+        REQUIRE(duration == 1500ms);
+        REQUIRE(parseDuration("0", duration));
+        REQUIRE(duration == 0ns);
+
+        REQUIRE(!parseDuration("", duration));
+        REQUIRE(!parseDuration("250", duration));
+        REQUIRE(!parseDuration("-1s", duration));
+        REQUIRE(!parseDuration("5x", duration));
+        REQUIRE(!parseDuration("300000d", duration));
+        REQUIRE(!parseDuration("99999999999999999999ns", duration));
+    }
+
+    SECTION( "byte sizes" ) {
+        std::uint64_t bytes = 0;
+
+        REQUIRE(parseByteSize("4096", bytes));
+        REQUIRE(bytes == 4096);
+        REQUIRE(parseByteSize("4KiB", bytes));
+        REQUIRE(bytes == 4096);
+        REQUIRE(parseByteSize("1.5G", bytes));
+        REQUIRE(bytes == 1610612736);
+        REQUIRE(parseByteSize("10MB", bytes));
+        REQUIRE(bytes == 10000000);
+
+        REQUIRE(!parseByteSize("", bytes));
+        REQUIRE(!parseByteSize("4QB", bytes));
+        REQUIRE(!parseByteSize("16E", bytes));
+        REQUIRE(!parseByteSize("1.5", bytes));
+        REQUIRE(!parseByteSize("0.5B", bytes));
+        REQUIRE(!parseByteSize("0.1K", bytes));
+        REQUIRE(bytes == 10000000);
+
+        REQUIRE(parseByteSize("1.0", bytes));
+        REQUIRE(bytes == 1);
+        REQUIRE(parseByteSize("0.5K", bytes));
+        REQUIRE(bytes == 512);
+    }
+
+    SECTION( "options" ) {
+        std::chrono::nanoseconds timeout {};
+        std::uint64_t bufferSize = 0;
+
+        const char* argv[] = {"programm", "--timeout", "2m", "--buffer", "64KiB", nullptr};
+
+        CmdParserFrame pars {
+            5,
+            const_cast<char**>(argv),
+            {
+                Option(&timeout, {"--timeout"}, "request timeout"),
+                Option(&bufferSize, {"--buffer"}, "buffer size")
+            }
+        };
+        pars.digest();
+
+        REQUIRE(timeout == 2min);
+        REQUIRE(bufferSize == 65536);
+    }
+
+    SECTION( "bad option value" ) {
+        std::chrono::nanoseconds timeout {};
+
+        const char* argv[] = {"programm", "--timeout", "soon", nullptr};
+
+        CmdParserFrame pars {
+            3,
+            const_cast<char**>(argv),
+            {
+                Option(&timeout, {"--timeout"}, "request timeout")
+            }
+        };
+
+        REQUIRE_THROWS_WITH(pars.digest(), "ERROR: Expected type >>duration<<, but got: soon");
+    }
+}
+
+
+#ifdef __linux__
+
+struct ReloadConfig {
+    int port = 80;
+    std::string name = "initial";
+    bool verbose = false;
+    int workers = 1;
+};
+
+struct CountedConfig {
+    static inline int alive = 0;
+    int port = 80;
+
+    CountedConfig() { ++alive; }
+    CountedConfig(const CountedConfig& other) : port(other.port) { ++alive; }
+    ~CountedConfig() { --alive; }
+};
+
+TEST_CASE( "reloadConfig", "[reload]" ) {
+    std::string path = "libcmd_reload_test.conf";
+    auto writeConfig = [&](const char* content) {
+        std::ofstream file(path + ".tmp");
+        file << content;
+        file.close();
+        std::rename((path + ".tmp").c_str(), path.c_str());
+    };
+    auto schema = [](ReloadConfig& config) -> std::list<Option> {
+        return {
+            Option(&config.port, {"--port"}, "port").setReloadable(),
+            Option(&config.name, {"--name"}, "name"),
+            Option(&config.verbose, {"--verbose"}).setReloadable(),
+            Option(&config.workers, {"--workers"}, "workers")
+        };
+    };
+
+    SECTION( "manual reload" ) {
+        writeConfig("# comment\n\n--port 8080\n--name changed\n");
+
+        std::string error;
+        ConfigReloader<ReloadConfig> reloader(path, ReloadConfig(), schema, [&](const std::string& e){ error = e; });
+        REQUIRE(reloader.current()->port == 80);
+
+        REQUIRE(reloader.reload());
+        REQUIRE(reloader.current()->port == 8080);
+        REQUIRE(reloader.current()->name == "initial");
+
+        writeConfig("--workers many\n--port 9090\n");
+        REQUIRE(reloader.reload());
+        REQUIRE(reloader.current()->port == 9090);
+        REQUIRE(reloader.current()->workers == 1);
+
+        writeConfig("--port nope\n");
+        REQUIRE(!reloader.reload());
+        REQUIRE(error == "ERROR: Expected type >>int<<, but got: nope");
+        REQUIRE(reloader.current()->port == 9090);
+    }
+
+    SECTION( "removed lines reset to the initial values" ) {
+        writeConfig("--port 8080\n--verbose\n");
+        ConfigReloader<ReloadConfig> reloader(path, ReloadConfig(), schema);
+        REQUIRE(reloader.reload());
+        REQUIRE(reloader.current()->verbose);
+
+        writeConfig("--port 8080\n");
+        REQUIRE(reloader.reload());
+        REQUIRE(!reloader.current()->verbose);
+        REQUIRE(reloader.current()->port == 8080);
+
+        writeConfig("");
+        REQUIRE(reloader.reload());
+        REQUIRE(reloader.current()->port == 80);
+    }
+
+    SECTION( "old snapshots are freed after their readers" ) {
+        writeConfig("--port 8080\n");
+        {
+            ConfigReloader<CountedConfig> reloader(path, CountedConfig(), [](CountedConfig& config) -> std::list<Option> {
+                return { Option(&config.port, {"--port"}, "port").setReloadable() };
+            });
+            for (int i = 0; i < 10; ++i) REQUIRE(reloader.reload());
+
+            // initial values and current snapshot
+            REQUIRE(CountedConfig::alive == 2);
+
+            std::atomic<bool> reloaded = false;
+            std::thread writer;
+            {
+                auto snapshot = reloader.current();
+                writer = std::thread([&] { reloaded = reloader.reload(); });
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+                // the old snapshot is published over but still pinned
+                REQUIRE(!reloaded);
+                REQUIRE(CountedConfig::alive == 3);
+                REQUIRE(snapshot->port == 8080);
+            }
+            writer.join();
+            REQUIRE(reloaded);
+            REQUIRE(CountedConfig::alive == 2);
+        }
+        REQUIRE(CountedConfig::alive == 0);
+    }
+
+    SECTION( "watched reload" ) {
+        writeConfig("--port 1\n");
+
+        ConfigReloader<ReloadConfig> reloader(path, ReloadConfig(), schema);
+        reloader.watch();
+        writeConfig("--port 2\n");
+
+        for (int i = 0; i < 500 && reloader.current()->port != 2; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        reloader.stop();
+
+        REQUIRE(reloader.current()->port == 2);
+    }
+
+    std::remove(path.c_str());
+}
+
+#endif
+
+
+static constexpr CommandSpec<5, 2> helpSpec {
+    "programname",
+    "Program description.",
+    {
+        HELP_OPTION,
+        LICENSE_OPTION,
+        OptionSpec{BOOL, {"--verbose"}},
+        OptionSpec{STRING, {"-i", "--input"}, "input string"},
+        OptionSpec{CHOICE, {"-m", "--mode"}, "execution mode", {}, "fast|safe|replay"}
+    },
+    {
+        SubCommandSpec{"print", "Print things."},
+        SubCommandSpec{"bake", "Bake things."}
+    }
+};
+
+static constexpr auto staticUsage = renderUsage<helpSpec>();
+static constexpr auto staticHelp = renderHelp<helpSpec>();
+
+static_assert(staticUsage.view().starts_with("\nUsage for: programname\n"));
+static_assert(staticHelp.view().starts_with("Program description.\n\nUsage for: programname\n"));
+
+TEST_CASE( "renderHelpAtCompileTime", "[statichelp]" ) {
+    bool verbose = false;
+    std::string input;
+    Mode mode = Mode::FAST;
+
+    const char* argv[] = {"programname", "--verbose", nullptr};
+
+    CmdParser pars {
+        2,
+        const_cast<char**>(argv),
+        {
+            Option(&verbose, {"--verbose"}),
+            Option(&input, {"-i", "--input"}, "input string"),
+            Option(&mode, choicesOf<modes>, {"-m", "--mode"}, "execution mode")
+        },
+        "programname",
+        "",
+        "Program description.",
+        "",
+        {
+            SubCommand({}, "print", nullptr, {}, "Print things."),
+            SubCommand({}, "bake", nullptr, {}, "Bake things.")
+        },
+        staticHelp
+    };
+
+    std::ostringstream out;
+    auto* old = std::cout.rdbuf(out.rdbuf());
+    pars.printAll();
+    std::cout.rdbuf(old);
+
+    REQUIRE(out.str() == std::string(staticUsage.view()));
+}
+
+TEST_CASE( "checkStaticHelp", "[statichelp]" ) {
+#ifndef NDEBUG
+    bool verbose = false;
+    const char* argv[] = {"programname", "--verbose", nullptr};
+
+    SECTION( "options differ from the spec" ) {
+        REQUIRE_THROWS_WITH(CmdParser(2, const_cast<char**>(argv),
+            {
+                Option(&verbose, {"--verbose"}, "now with description")
+            },
+            "programname", "", "Program description.", "",
+            {
+                SubCommand({}, "print", nullptr, {}, "Print things."),
+                SubCommand({}, "bake", nullptr, {}, "Bake things.")
+            },
+            staticHelp
+        ), "ERROR: Static help of >>programname<< differs from its Options");
+    }
+
+    SECTION( "static help of a SubCommand" ) {
+        REQUIRE_THROWS_WITH(CmdParser(2, const_cast<char**>(argv),
+            {
+                Option(&verbose, {"--verbose"})
+            },
+            "programname", "", "", "",
+            {
+                SubCommand({}, "sub", nullptr, {}, "", staticHelp)
+            }
+        ), "ERROR: Static help of >>programname sub<< differs from its Options");
+    }
+#endif
+}
+
+
+static constexpr CommandSpec<2, 1> conflictingSpec {
+    "programname",
+    "",
+    {
+        HELP_OPTION,
+        OptionSpec{BOOL, {"-h", "--hidden"}}
+    },
+    {
+        SubCommandSpec{"--hidden"}
+    }
+};
+
+static_assert(checkSpec<helpSpec>());
+static_assert(hasDuplicateHand(conflictingSpec));
+static_assert(hasHandShadowingSubCommand(conflictingSpec));
+static_assert(!hasBlankHand(conflictingSpec));
+static_assert(hasBlankHand(OptionSpec{BOOL, {"-a", "", "-b"}}));
+static_assert(hasBlankHand(OptionSpec{BOOL, {"-a b"}}));
+
+TEST_CASE( "checkHands", "[checkhands]" ) {
+#ifndef NDEBUG
+    bool flag = false;
+    const char* argv[] = {"programm", "--flag", nullptr};
+
+    SECTION( "duplicate hand" ) {
+        REQUIRE_THROWS_WITH(
+            CmdParserFrame(2, const_cast<char**>(argv), {Option(&flag, {"--flag"}), Option(&flag, {"-f"}, "", {"--flag"})}),
+            "ERROR: Hand >>--flag<< is used by more than one option in: program"
+        );
+    }
+
+    SECTION( "user hand shadows built in help" ) {
+        REQUIRE_THROWS_WITH(
+            SubCommand({Option(&flag, {"-h"})}, "sub"),
+            "ERROR: Hand >>-h<< is used by more than one option in: sub"
+        );
+    }
+
+    SECTION( "blank hand" ) {
+        REQUIRE_THROWS(CmdParserFrame(2, const_cast<char**>(argv), {Option(&flag, {"--fl ag"})}));
+        REQUIRE_THROWS(CmdParserFrame(2, const_cast<char**>(argv), {Option(&flag, {""})}));
+    }
+
+    SECTION( "hand shadows subcommand" ) {
+        REQUIRE_THROWS_WITH(
+            CmdParserFrame(2, const_cast<char**>(argv), {Option(&flag, {"sub"})}, {SubCommand({}, "sub")}),
+            "ERROR: Hand >>sub<< shadows the SubCommand of the same name in: program"
+        );
+    }
+
+    SECTION( "no conflicts" ) {
+        REQUIRE_NOTHROW(CmdParserFrame(2, const_cast<char**>(argv), {Option(&flag, {"--flag"})}, {SubCommand({}, "sub")}));
+    }
+#endif
+}
+
+
+TEST_CASE( "subcommandTree", "[subcommandtree]" ) {
+    SECTION( "wide tree" ) {
+        std::array<bool, 200> called {};
+        std::vector<CmdParserFrame> subCommands;
+        for (int i = 0; i < 200; ++i) {
+            subCommands.push_back(SubCommand({}, "cmd" + std::to_string(i), &called[i]));
+        }
+
+        const char* argv[] = {"programm", "cmd137", nullptr};
+
+        CmdParserFrame pars {
+            2,
+            const_cast<char**>(argv),
+            {},
+            subCommands
+        };
+        pars.digest();
+
+        REQUIRE(called[137]);
+        REQUIRE(std::count(called.begin(), called.end(), true) == 1);
+    }
+
+    SECTION( "usage of nested subcommand" ) {
+        bool subsubGotCalled = false;
+
+        const char* argv[] = {"programm", "sub", "subsub", nullptr};
+
+        CmdParserFrame pars {
+            3,
+            const_cast<char**>(argv),
+            {},
+            {
+                SubCommand({}, "sub", nullptr, {
+                    SubCommand({}, "subsub", &subsubGotCalled, {}, "second level")
+                }),
+                SubCommand({}, "other")
+            }
+        };
+        pars.digest();
+
+        std::ostringstream out;
+        pars.printAll(SPACES, false, out);
+
+        REQUIRE(subsubGotCalled);
+        REQUIRE(pars.validate().path == "program sub subsub");
+        REQUIRE(out.str().starts_with("\nUsage for: program\n"));
+    }
+
+    SECTION( "subcommand on its own" ) {
+        bool b = false;
+        SubCommand sub({Option(&b, {"-b"}, "a flag")}, "sub", nullptr, {SubCommand({}, "subsub")});
+
+        std::ostringstream out;
+        sub.printAll(SPACES, false, out);
+
+        REQUIRE(out.str().starts_with("\nUsage for: sub\n"));
+        REQUIRE(out.str().find("subsub") != std::string::npos);
+        REQUIRE(sub.searchHelp("a flag").size() == 1);
+        REQUIRE(sub.validate(std::vector<std::string>{"subsub"}).path == "sub subsub");
+        REQUIRE(sub.exportSchema().starts_with("{\"name\":\"sub\""));
+    }
+}
+
+
+TEST_CASE( "validateUtf8", "[utf8]" ) {
+    SECTION( "validator" ) {
+        REQUIRE(isValidUtf8(""));
+        REQUIRE(isValidUtf8("plain ascii which is longer than thirty two bytes, to hit the vector path"));
+        REQUIRE(isValidUtf8("gr\xc3\xbc\xc3\x9f \xe2\x82\xac \xf0\x9f\x98\x80"));
+
+        REQUIRE(findInvalidUtf8("abc\xff") == 3);
+        REQUIRE(findInvalidUtf8("abcdefghijklmnopqrstuvwxyz0123456789\xc3") == 36);
+        REQUIRE(!isValidUtf8("\xc0\xaf"));
+        REQUIRE(!isValidUtf8("\xe0\x80\xaf"));
+        REQUIRE(!isValidUtf8("\xed\xa0\x80"));
+        REQUIRE(!isValidUtf8("\xf4\x90\x80\x80"));
+        REQUIRE(!isValidUtf8("\xe2\x82"));
+    }
+
+    SECTION( "arguments" ) {
+        std::string inputStr;
+
+        const char* argv[] = {"programm", "-s", "ok", "-s", "bad\xff", nullptr};
+
+        CmdParserFrame pars {
+            5,
+            const_cast<char**>(argv),
+            {
+                Option(&inputStr, {"-s"}, "input string")
+            }
+        };
+
+        REQUIRE_NOTHROW(pars.digest());
+        pars.setUtf8Validation();
+        REQUIRE_THROWS_WITH(pars.digest(), "ERROR: Invalid UTF-8 in argument 4 at byte 3");
+    }
+}
+
+
+TEST_CASE( "parseCallbackOptions", "[callbacks]" ) {
+    int number = 0;
+    std::string_view text;
+    std::chrono::nanoseconds timeout {};
+    int flagCalls = 0;
+
+    const char* argv[] = {"programm", "-n", "42", "-s", "wasd", "--timeout", "5s", "--flag", "--flag", nullptr};
+
+    CmdParserFrame pars {
+        9,
+        const_cast<char**>(argv),
+        {
+            Option([&number](int value) { number = value; }, {"-n"}, "number"),
+            Option([&text](std::string_view value) { text = value; }, {"-s"}, "string"),
+            Option([&timeout](std::chrono::nanoseconds value) { timeout = value; }, {"--timeout"}, "timeout"),
+            Option([&flagCalls]() { ++flagCalls; }, {"--flag"}, "flag")
+        }
+    };
+    pars.digest();
+
+    REQUIRE(number == 42);
+    REQUIRE(text == "wasd");
+    REQUIRE(text.data() == argv[4]);
+    REQUIRE(timeout == std::chrono::seconds(5));
+    REQUIRE(flagCalls == 2);
+
+    SECTION( "bad value does not call back" ) {
+        const char* badArgv[] = {"programm", "-n", "abc", nullptr};
+        int calls = 0;
+
+        CmdParserFrame badPars {
+            3,
+            const_cast<char**>(badArgv),
+            {
+                Option([&calls](int) { ++calls; }, {"-n"}, "number")
+            }
+        };
+
+        REQUIRE_THROWS_WITH(badPars.digest(), "ERROR: Expected type >>int<<, but got: abc");
+        REQUIRE(calls == 0);
+    }
+
+    SECTION( "generic lambdas take the parser" ) {
+        const char* genericArgv[] = {"programm", "-x", nullptr};
+        void* parser = nullptr;
+
+        CmdParserFrame genericPars {
+            2,
+            const_cast<char**>(genericArgv),
+            {
+                Option([&parser](auto* self) { parser = self; }, {"-x"})
+            }
+        };
+        genericPars.digest();
+
+        REQUIRE(parser == &genericPars);
+    }
+}
+
+
+TEST_CASE( "parseEvents", "[events]" ) {
+    std::string inputStr = "NONE";
+    int inputInt = 0;
+    bool flag = false;
+    bool subGotCalled = false;
+
+    const char* argv[] = {"programm", "sub", "-i", "abc", "--flag", "-s", "wasd", "positional", nullptr};
+
+    CmdParserFrame pars {
+        8,
+        const_cast<char**>(argv),
+        {},
+        {
+            SubCommand({
+                Option(&inputStr, {"-s"}, "input string"),
+                Option(&inputInt, {"-i"}, "input int"),
+                Option(&flag, {"--flag"})
+            }, "sub", &subGotCalled)
+        }
+    };
+
+    SECTION( "all events" ) {
+        std::vector<EventKind> kinds;
+        std::vector<std::size_t> positions;
+        for (auto& event : pars.events()) {
+            kinds.push_back(event.kind);
+            positions.push_back(event.position);
+        }
+
+        REQUIRE(kinds == std::vector<EventKind>{SUBCOMMAND_ENTERED, OPTION_MATCHED, PARSE_ERROR, OPTION_MATCHED, OPTION_MATCHED, VALUE_CONVERTED, POSITIONAL});
+        REQUIRE(positions == std::vector<std::size_t>{1, 2, 3, 4, 5, 6, 7});
+        REQUIRE(inputStr == "NONE");
+        REQUIRE(!flag);
+        REQUIRE(!subGotCalled);
+    }
+
+    SECTION( "stop at subcommand" ) {
+        std::size_t count = 0;
+        for (auto& event : pars.events()) {
+            ++count;
+            if (event.kind == SUBCOMMAND_ENTERED) {
+                REQUIRE(event.token == "sub");
+                break;
+            }
+        }
+        REQUIRE(count == 1);
+    }
+
+    SECTION( "streamed tokens" ) {
+        std::istringstream stream("sub -s streamed -i 7");
+        std::vector<std::string> values;
+        for (auto& event : pars.events(std::ranges::istream_view<std::string>(stream))) {
+            if (event.kind == VALUE_CONVERTED && event.option->getType() == STRING) {
+                values.emplace_back(std::get<std::string_view>(event.value));
+            }
+            if (event.kind == VALUE_CONVERTED && event.option->getType() == INT) {
+                REQUIRE(std::get<int>(event.value) == 7);
+            }
+        }
+        REQUIRE(values == std::vector<std::string>{"streamed"});
+    }
+}
+
+
+TEST_CASE( "parseWithCache", "[cache]" ) {
+    ParseCache cache(2);
+
+    auto parse = [&](std::vector<std::string> arguments, std::string& inputStr, int& inputInt, int& calls, bool& subGotCalled) {
+        std::vector<char*> argv;
+        argv.push_back(const_cast<char*>("programm"));
+        for (auto& argument : arguments) argv.push_back(argument.data());
+        argv.push_back(nullptr);
+
+        CmdParserFrame pars {
+            int(argv.size()) - 1,
+            argv.data(),
+            {},
+            {
+                SubCommand({
+                    Option(&inputStr, {"-s"}, "input string"),
+                    Option(&inputInt, {"-i"}, "input int"),
+                    Option([&calls]() { ++calls; }, {"-v"})
+                }, "sub", &subGotCalled)
+            }
+        };
+        pars.digest(cache);
+    };
+
+    std::string inputStr = "NONE";
+    int inputInt = 0;
+    int calls = 0;
+    bool subGotCalled = false;
+
+    SECTION( "hit applies cached values" ) {
+        parse({"sub", "-s", "abc", "-i", "42", "-v"}, inputStr, inputInt, calls, subGotCalled);
+        REQUIRE(cache.misses() == 1);
+        REQUIRE(cache.hits() == 0);
+
+        std::string otherStr = "NONE";
+        int otherInt = 0;
+        int otherCalls = 0;
+        bool otherSubGotCalled = false;
+        parse({"sub", "-s", "abc", "-i", "42", "-v"}, otherStr, otherInt, otherCalls, otherSubGotCalled);
+        REQUIRE(cache.hits() == 1);
+        REQUIRE(otherStr == "abc");
+        REQUIRE(otherInt == 42);
+        REQUIRE(otherCalls == 1);
+        REQUIRE(otherSubGotCalled);
+    }
+
+    SECTION( "different arguments miss" ) {
+        parse({"sub", "-i", "1"}, inputStr, inputInt, calls, subGotCalled);
+        parse({"sub", "-i", "12"}, inputStr, inputInt, calls, subGotCalled);
+        parse({"sub", "-s", "1"}, inputStr, inputInt, calls, subGotCalled);
+        REQUIRE(cache.misses() == 3);
+        REQUIRE(cache.hits() == 0);
+        REQUIRE(inputInt == 12);
+    }
+
+    SECTION( "invalid arguments are not cached" ) {
+        REQUIRE_THROWS(parse({"sub", "-i", "abc"}, inputStr, inputInt, calls, subGotCalled));
+        REQUIRE_THROWS(parse({"sub", "-i", "abc"}, inputStr, inputInt, calls, subGotCalled));
+        REQUIRE(cache.size() == 0);
+        REQUIRE(cache.misses() == 2);
+    }
+
+    SECTION( "least recently used is evicted" ) {
+        parse({"sub", "-i", "1"}, inputStr, inputInt, calls, subGotCalled);
+        parse({"sub", "-i", "2"}, inputStr, inputInt, calls, subGotCalled);
+        parse({"sub", "-i", "1"}, inputStr, inputInt, calls, subGotCalled);
+        parse({"sub", "-i", "3"}, inputStr, inputInt, calls, subGotCalled);
+        REQUIRE(cache.size() == 2);
+        REQUIRE(cache.hits() == 1);
+
+        parse({"sub", "-i", "1"}, inputStr, inputInt, calls, subGotCalled);
+        REQUIRE(cache.hits() == 2);
+        parse({"sub", "-i", "2"}, inputStr, inputInt, calls, subGotCalled);
+        REQUIRE(cache.hits() == 2);
+        REQUIRE(inputInt == 2);
+    }
+}
+
+
+static_assert(SPACES == 12);
+static_assert(LICENSENOTICE.find("libcmd") != std::string_view::npos);
+
+TEST_CASE( "builtInOptions", "[builtins]" ) {
+    bool subGotCalled = false;
+    int inputInt = 0;
+
+    const char* argv[] = {"programm", "-i", "--help", "sub", "/h", "--license", nullptr};
+
+    CmdParser pars {
+        6,
+        const_cast<char**>(argv),
+        {
+            Option(&inputInt, {"-i"}, "input int")
+        },
+        "programm",
+        "", "", "",
+        {
+            SubCommand({}, "sub", &subGotCalled)
+        }
+    };
+
+    std::vector<EventKind> kinds;
+    std::vector<const OptionSpec*> builtIns;
+    for (auto& event : pars.events()) {
+        kinds.push_back(event.kind);
+        builtIns.push_back(event.builtIn);
+    }
+
+    REQUIRE(kinds == std::vector<EventKind>{OPTION_MATCHED, BUILT_IN_MATCHED, HELP_TERM, BUILT_IN_MATCHED, BUILT_IN_MATCHED});
+    REQUIRE(builtIns[1] == &BUILT_IN_OPTIONS[0]);
+    REQUIRE(builtIns[2] == &BUILT_IN_OPTIONS[0]);
+    REQUIRE(builtIns[3] == &BUILT_IN_OPTIONS[0]);
+    REQUIRE(builtIns[4] == &BUILT_IN_OPTIONS[1]);
+
+    SECTION( "subcommands only know help" ) {
+        const char* subArgv[] = {"programm", "sub", "/h", "--license", nullptr};
+        CmdParser subPars {4, const_cast<char**>(subArgv), {}, "programm", "", "", "", {SubCommand({}, "sub", &subGotCalled)}};
+        kinds.clear();
+        builtIns.clear();
+        for (auto& event : subPars.events()) {
+            kinds.push_back(event.kind);
+            builtIns.push_back(event.builtIn);
+            REQUIRE((event.kind != VALUE_CONVERTED || event.option));
+        }
+        REQUIRE(kinds == std::vector<EventKind>{SUBCOMMAND_ENTERED, BUILT_IN_MATCHED, HELP_TERM});
+        REQUIRE(builtIns[2] == &BUILT_IN_OPTIONS[0]);
+    }
+
+#ifndef NDEBUG
+    SECTION( "hands of built in flags are taken" ) {
+        REQUIRE_THROWS_WITH(SubCommand({Option(&inputInt, {"/h"})}, "sub"), "ERROR: Hand >>/h<< is used by more than one option in: sub");
+    }
+#endif
+}
+
+
+
+TEST_CASE( "searchHelp", "[searchhelp]" ) {
+    std::string input;
+    int jobs = 0;
+    bool verbose = false;
+    bool subGotCalled = false;
+
+    const char* argv[] = {"programm", "--help", "input", nullptr};
+
+    CmdParser pars {
+        3,
+        const_cast<char**>(argv),
+        {
+            Option(&verbose, {"--verbose"}, "Print more output.")
+        },
+        "programm",
+        "", "", "",
+        {
+            SubCommand({
+                Option(&input, {"-i", "--input"}, "Input file."),
+                Option(&jobs, {"-j"}, "Number of parallel jobs.")
+            }, "build", &subGotCalled, {}, "Build the input."),
+            SubCommand({}, "clean", nullptr, {}, "Remove build output.")
+        }
+    };
+
+    SECTION( "help is followed by the search term" ) {
+        std::vector<EventKind> kinds;
+        std::string term;
+        for (auto& event : pars.events()) {
+            kinds.push_back(event.kind);
+            if (event.kind == HELP_TERM) term = event.token;
+        }
+        REQUIRE(kinds == std::vector<EventKind>{BUILT_IN_MATCHED, HELP_TERM});
+        REQUIRE(term == "input");
+    }
+
+    SECTION( "hands, descriptions and subcommands" ) {
+        auto matches = pars.searchHelp("INPUT");
+        REQUIRE(matches.size() == 2);
+        REQUIRE(matches[0].path == "programm");
+        REQUIRE(matches[0].isSubCommand);
+        REQUIRE(matches[0].hands == std::vector<std::string>{"build"});
+        REQUIRE(matches[1].path == "programm build");
+        REQUIRE(matches[1].hands == std::vector<std::string>{"-i", "--input"});
+        REQUIRE(matches[1].description == "Input file.");
+
+        REQUIRE(pars.searchHelp("-j").size() == 1);
+        REQUIRE(pars.searchHelp("license").size() == 1);
+        REQUIRE(pars.searchHelp("build").size() == 2);
+        REQUIRE(pars.searchHelp("nothing like this").empty());
+    }
+
+    SECTION( "printed rows" ) {
+        std::ostringstream out;
+        auto* old = std::cout.rdbuf(out.rdbuf());
+        pars.printSearch("jobs");
+        std::cout.rdbuf(old);
+        REQUIRE(out.str() == "\nMatches for: jobs\n\nprogramm build          -j          Number of parallel jobs.\n\n");
+    }
+}
+
+
+TEST_CASE( "passthroughTail", "[passthrough]" ) {
+    bool verbose = false;
+    std::string dir = "NONE";
+    bool runGotCalled = false;
+    std::span<char*> tail;
+
+    auto makeParser = [&](int argc, const char** argv) {
+        return CmdParserFrame {
+            argc,
+            const_cast<char**>(argv),
+            {},
+            {
+                SubCommand({
+                    Option(&verbose, {"-v"}),
+                    Option(&dir, {"-C"}, "working directory")
+                }, "run", &runGotCalled, {}, "", {}, &tail)
+            }
+        };
+    };
+
+    SECTION( "stops at the first positional" ) {
+        const char* argv[] = {"programm", "run", "-v", "-C", "/tmp", "ls", "-v", "--", nullptr};
+        auto pars = makeParser(8, argv);
+        pars.digest();
+        REQUIRE(verbose);
+        REQUIRE(dir == "/tmp");
+        REQUIRE(runGotCalled);
+        REQUIRE(tail.size() == 3);
+        REQUIRE(tail.data() == const_cast<char**>(argv) + 5);
+        REQUIRE(std::string_view(tail[1]) == "-v");
+    }
+
+    SECTION( "stops after --" ) {
+        const char* argv[] = {"programm", "run", "--", "-v", nullptr};
+        auto pars = makeParser(4, argv);
+        pars.digest();
+        REQUIRE(!verbose);
+        REQUIRE(tail.size() == 1);
+        REQUIRE(tail.data() == const_cast<char**>(argv) + 3);
+    }
+
+    SECTION( "empty tail" ) {
+        const char* argv[] = {"programm", "run", "-v", "--", nullptr};
+        auto pars = makeParser(4, argv);
+        pars.digest();
+        REQUIRE(verbose);
+        REQUIRE(tail.empty());
+    }
+
+    SECTION( "cached" ) {
+        const char* argv[] = {"programm", "run", "echo", "hi", nullptr};
+        ParseCache cache;
+        makeParser(4, argv).digest(cache);
+        tail = {};
+        makeParser(4, argv).digest(cache);
+        REQUIRE(cache.hits() == 1);
+        REQUIRE(tail.size() == 2);
+        REQUIRE(std::string_view(tail[0]) == "echo");
+    }
+
+    SECTION( "mistyped options do not start the tail" ) {
+        const char* argv[] = {"programm", "run", "--verbsoe", "rm", "-rf", "x", nullptr};
+        auto pars = makeParser(6, argv);
+        REQUIRE_THROWS_WITH(pars.digest(), "ERROR: Unkown argument: --verbsoe");
+        REQUIRE(tail.empty());
+    }
+
+    SECTION( "a single dash starts the tail" ) {
+        const char* argv[] = {"programm", "run", "-", nullptr};
+        auto pars = makeParser(3, argv);
+        pars.digest();
+        REQUIRE(tail.size() == 1);
+    }
+
+    SECTION( "other commands still reject positionals" ) {
+        const char* argv[] = {"programm", "ls", nullptr};
+        auto pars = makeParser(2, argv);
+        REQUIRE_THROWS_WITH(pars.digest(), "ERROR: Unkown argument: ls");
+    }
+}
+
+
+static constexpr CommandSpec<2, 1> schemaSpec {
+    "programm",
+    "Say \"hi\".",
+    {
+        HELP_OPTION,
+        OptionSpec{CHOICE, {"-m"}, "mode", {}, "fast|safe"}
+    },
+    {
+        SubCommandSpec{"sub", "a sub"}
+    }
+};
+static constexpr auto staticSchema = renderSchema<schemaSpec>();
+static_assert(staticSchema.view() ==
+    R"({"name":"programm","description":"Say \"hi\".","options":[)"
+    R"({"type":"lambda","hands":["-h","--help"],"anonymousHands":["/h"],"description":"Show this message."},)"
+    R"({"type":"choice","hands":["-m"],"anonymousHands":[],"description":"mode","choices":["fast","safe"]}],)"
+    R"("subCommands":[{"name":"sub","description":"a sub"}]})");
+
+static constexpr CommandSpec<1> noChoicesSpec {"programm sub", "", {OptionSpec{CHOICE, {"-m"}}}};
+static_assert(renderSchema<noChoicesSpec>().view() ==
+    R"({"name":"programm sub","description":"","options":[)"
+    R"({"type":"choice","hands":["-m"],"anonymousHands":[],"description":"","choices":[]}],"subCommands":[]})");
+
+static constexpr Choices<int, 2> pipes {{"a|b", "c"}, {1, 2}};
+
+TEST_CASE( "exportSchema", "[schema]" ) {
+    int inputInt = 0;
+    int pipe = 0;
+    std::chrono::nanoseconds timeout {};
+    std::span<char*> tail;
+
+    const char* argv[] = {"programm", "run", nullptr};
+
+    CmdParserFrame pars {
+        2,
+        const_cast<char**>(argv),
+        {
+            Option(&inputInt, {"-i"}, "input\tint", {"--int"})
+        },
+        {
+            SubCommand({
+                Option(&timeout, {"--timeout"}),
+                Option(&pipe, choicesOf<pipes>, {"-p"})
+            }, "run", nullptr, {}, "Run it.", {}, &tail)
+        }
+    };
+
+    std::string_view schema = pars.exportSchema();
+    REQUIRE(schema ==
+        R"({"name":"program","description":"","options":[)"
+        R"({"type":"int","hands":["-i"],"anonymousHands":["--int"],"description":"input\tint"}],)"
+        R"("subCommands":[{"name":"run","description":"Run it.","passthrough":true,"options":[)"
+        R"({"type":"lambda","hands":["-h","--help"],"anonymousHands":["/h"],"description":"Show this message."},)"
+        R"({"type":"duration","hands":["--timeout"],"anonymousHands":[],"description":""},)"
+        R"({"type":"choice","hands":["-p"],"anonymousHands":[],"description":"","choices":["a|b","c"]}],"subCommands":[]}]})");
+    REQUIRE(pars.exportSchema().data() == schema.data());
+
+    CmdParserFrame copy = pars;
+    REQUIRE(copy.exportSchema().data() == schema.data());
+}
+
+
+TEST_CASE( "validateWithoutSideEffects", "[validate]" ) {
+    int inputInt = 0;
+    double inputDouble = 0.0;
+    int calls = 0;
+    bool subGotCalled = false;
+    std::span<char*> tail;
+
+    const char* argv[] = {"programm", "sub", "-i", "abc", "-v", "stray", "-d", "1.5", "--help", nullptr};
+
+    CmdParser pars {
+        9,
+        const_cast<char**>(argv),
+        {},
+        "programm",
+        "", "", "",
+        {
+            SubCommand({
+                Option(&inputInt, {"-i"}, "input int"),
+                Option(&inputDouble, {"-d"}, "input double"),
+                Option([&calls]() { ++calls; }, {"-v"})
+            }, "sub", &subGotCalled),
+            SubCommand({}, "run", nullptr, {}, "", {}, &tail)
+        }
+    };
+
+    SECTION( "all problems of argv" ) {
+        ValidationResult result = pars.validate();
+        REQUIRE(result.path == "programm sub");
+        REQUIRE(!result.isValid());
+        REQUIRE(result.diagnostics.size() == 2);
+        REQUIRE(result.diagnostics[0].position == 3);
+        REQUIRE(result.diagnostics[0].message == "ERROR: Expected type >>int<<, but got: abc");
+        REQUIRE(result.diagnostics[1].position == 5);
+        REQUIRE(result.diagnostics[1].message == "ERROR: Unkown argument: stray");
+
+        REQUIRE(inputInt == 0);
+        REQUIRE(inputDouble == 0.0);
+        REQUIRE(calls == 0);
+        REQUIRE(!subGotCalled);
+    }
+
+    SECTION( "tokens" ) {
+        ValidationResult result = pars.validate(std::vector<std::string>{"sub", "-i", "4", "-d", "2"});
+        REQUIRE(result.isValid());
+        REQUIRE(result.path == "programm sub");
+        REQUIRE(inputInt == 0);
+
+        result = pars.validate(std::vector<std::string>{"run", "-x", "--", "ls"});
+        REQUIRE(result.diagnostics.size() == 1);
+        REQUIRE(result.diagnostics[0].position == 2);
+        REQUIRE(result.diagnostics[0].message == "ERROR: Unkown argument: -x");
+        REQUIRE(result.path == "programm run");
+        REQUIRE(result.passthroughPosition == 4);
+        REQUIRE(tail.empty());
+
+        result = pars.validate(std::vector<std::string>{"run", "--", "-x"});
+        REQUIRE(result.isValid());
+        REQUIRE(result.passthroughPosition == 3);
+
+        REQUIRE(pars.validate(std::vector<std::string>{}).path == "programm");
+    }
+
+    SECTION( "utf8" ) {
+        pars.setUtf8Validation();
+        ValidationResult result = pars.validate(std::vector<std::string>{"sub", "-i", "\xff"});
+        REQUIRE(result.diagnostics.size() == 2);
+        REQUIRE(result.diagnostics[0].message == "ERROR: Invalid UTF-8 in argument 3 at byte 0");
+    }
+
+    SECTION( "utf8 of the passthrough tail" ) {
+        const char* tailArgv[] = {"programm", "run", "ls\xff", "x\xff", nullptr};
+        CmdParser wrapper {4, const_cast<char**>(tailArgv), {}, "programm", "", "", "", {SubCommand({}, "run", nullptr, {}, "", {}, &tail)}};
+        wrapper.setUtf8Validation();
+
+        ValidationResult result = wrapper.validate();
+        REQUIRE(result.passthroughPosition == 2);
+        REQUIRE(result.diagnostics.size() == 2);
+        REQUIRE(result.diagnostics[0].message == "ERROR: Invalid UTF-8 in argument 2 at byte 2");
+        REQUIRE(result.diagnostics[1].message == "ERROR: Invalid UTF-8 in argument 3 at byte 1");
+    }
+}